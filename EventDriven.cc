@@ -35,23 +35,18 @@
 #include <queue>
 #include <time.h>
 #include <stdio.h>
-#include "parse_bench.tab.h"
 #include "ClassCircuit.h"
+#include "ClassBenchParser.h"
 #include "ClassGate.h"
+#include "ClassLevelQueue.h"
 #include <limits>
 #include <stdlib.h>
 #include <time.h>
 
 using namespace std;
 
-/**  @brief Just for the parser. Don't touch. */
-extern "C" int yyparse();
-
-/**  Input file for parser. Don't touch. */
-extern FILE *yyin;
-
-/** Our circuit. We declare this external so the parser can use it more easily. */
-extern Circuit* myCircuit;
+/** Our circuit. */
+Circuit* myCircuit;
 
 //--------------------------
 // Helper functions
@@ -64,21 +59,21 @@ string printPIValue(char v);
 //----------------------------
 // Functions for logic simulation
 void simFullCircuit(Circuit* myCircuit);
-void simGateRecursive(Gate* g);
-void eventDrivenSim(Circuit* myCircuit, queue<Gate*> q);
-char simGate(Gate* g);
+void simGateRecursive(int g, Circuit* myCircuit);
+void eventDrivenSim(Circuit* myCircuit, LevelQueue &q);
+char simGate(int g, Circuit* myCircuit);
 char evalGate(vector<char> in, int c, int i);
 char EvalXORGate(vector<char> in, int inv);
 int LogicNot(int logicVal);
-void setValueCheckFault(Gate* g, char gateValue);
+void setValueCheckFault(int g, char gateValue);
 //-----------------------------
 
 //----------------------------
 // Functions for PODEM:
 bool podemRecursion(Circuit* myCircuit);
-bool getObjective(Gate* &g, char &v, Circuit* myCircuit);
+bool getObjective(int &g, char &v, Circuit* myCircuit);
 void updateDFrontier(Circuit* myCircuit);
-void backtrace(Gate* &pi, char &piVal, Gate* objGate, char objVal, Circuit* myCircuit);
+void backtrace(int &pi, char &piVal, int objGate, char objVal, Circuit* myCircuit);
 
 //--------------------------
 
@@ -86,12 +81,23 @@ void backtrace(Gate* &pi, char &piVal, Gate* objGate, char objVal, Circuit* myCi
 ///////////////////////////////////////////////////////////
 // Global variables
 // These are made global to make your life slightly easier.
+// Gates are identified by their index in the compiled form of the circuit
+// (see Circuit::getFanin(), Circuit::getFanout()).
+
+/** Global variable: the logic value of each gate's output, indexed by gate. */
+vector<char> gateValues;
+
+/** Global variable: the levelized queue of gates waiting to be evaluated by eventDrivenSim(). */
+LevelQueue eventQueue;
 
-/** Global variable: a vector of Gate pointers for storing the D-Frontier. */
-vector<Gate*> dFrontier;
+/** Global variable: a vector of gate indices for storing the D-Frontier. */
+vector<int> dFrontier;
 
-/** Global variable: holds a pointer to the gate with stuck-at fault on its output location. */
-Gate* faultLocation;     
+/** Global variable: holds the index of the gate with stuck-at fault on its output location. */
+int faultLocation;     
+
+/** Global variable: holds the type of the stuck-at fault (FAULT_SA0 or FAULT_SA1). */
+char faultLocationType;
 
 /** Global variable: holds the logic value you will need to activate the stuck-at fault. */
 char faultActivationVal;
@@ -114,17 +120,17 @@ int main(int argc, char* argv[]) {
     return 1;
   }
   
-  // Parse the bench file and initialize the circuit. (Using C style for our parser.)
-  FILE *benchFile = fopen(argv[1], "r");
-  if (benchFile == NULL) {
-    cout << "ERROR: Cannot read file " << argv[1] << " for input" << endl;
+  // Parse the bench file and initialize the circuit.
+  BenchParser parser;
+  myCircuit = parser.parse(argv[1]);
+  if (myCircuit == NULL) {
+    cout << "ERROR: " << parser.getError() << endl;
     return 1;
   }
-  yyin=benchFile;
-  yyparse();
-  fclose(benchFile);
 
   myCircuit->setupCircuit();
+  gateValues.resize(myCircuit->getNumberGates());
+  eventQueue.init(myCircuit);
 
   cout << endl;
    
@@ -151,9 +157,6 @@ int main(int argc, char* argv[]) {
   // For each line in our fault file...
   while(getline(faultStream, faultLocStr)) {
 
-    // Clear the old fault
-    myCircuit->clearFaults();
-      
     string faultTypeStr;
       
     if (!(getline(faultStream, faultTypeStr))) {
@@ -163,14 +166,16 @@ int main(int argc, char* argv[]) {
     char faultType = atoi(faultTypeStr.c_str());
       
     // set up the fault we are trying to detect
-    faultLocation = myCircuit->findGateByName(faultLocStr);      
-    faultLocation->set_faultType(faultType);      
+    faultLocation = myCircuit->findGateIndexByName(faultLocStr);
+    if (faultLocation < 0) {
+      cout << "ERROR: Cannot find fault location " << faultLocStr << " in circuit" << endl;
+      return 1;
+    }
+    faultLocationType = faultType;
     faultActivationVal = (faultType == FAULT_SA0) ? LOGIC_ONE : LOGIC_ZERO;
       
     // set all gate values to X
-    for (int i=0; i < myCircuit->getNumberGates(); i++) {
-      myCircuit->getGate(i)->setValue(LOGIC_X);
-    }
+    fill(gateValues.begin(), gateValues.end(), LOGIC_X);
 
     // initialize the D frontier.
     dFrontier.clear();
@@ -180,9 +185,9 @@ int main(int argc, char* argv[]) {
 
     // If we succeed, print the test we found to the output file.
     if (res == true) {
-      vector<Gate*> piGates = myCircuit->getPIGates();
+      const vector<uint32_t>& piGates = myCircuit->getPIIndices();
       for (int i=0; i < piGates.size(); i++)
-        outputStream << printPIValue(piGates[i]->getValue());
+        outputStream << printPIValue(gateValues[piGates[i]]);
       outputStream << endl;
     }
 
@@ -200,13 +205,17 @@ int main(int argc, char* argv[]) {
     if (res == true) {
       if (!checkTest(myCircuit)) {
         cout << "ERROR: PODEM returned true, but generated test does not detect fault on PO." << endl;
+        myCircuit->buildGates();
+        myCircuit->getGate(faultLocation)->set_faultType(faultLocationType);
+        for (int i=0; i < myCircuit->getNumberGates(); i++)
+          myCircuit->getGate(i)->setValue(gateValues[i]);
         myCircuit->printAllGates();
         assert(false);
       }
     }
 
     // Just printing to screen to let you monitor progress
-    cout << "Fault = " << faultLocation->get_outputName() << " / " << (int)(faultType) << ";";
+    cout << "Fault = " << myCircuit->getGateName(faultLocation) << " / " << (int)(faultType) << ";";
     if (res == true)
       cout << " test found" << endl;
     else
@@ -299,9 +308,9 @@ bool checkTest(Circuit* myCircuit) {
   simFullCircuit(myCircuit);
 
   // look for D or D' on an output
-  vector<Gate*> poGates = myCircuit->getPOGates();
+  const vector<uint32_t>& poGates = myCircuit->getPOIndices();
   for (int i=0; i<poGates.size(); i++) {
-    char v = poGates[i]->getValue();
+    char v = gateValues[poGates[i]];
     if ((v == LOGIC_D) || (v == LOGIC_DBAR)) {
       return true;
     }
@@ -347,24 +356,23 @@ string printPIValue(char v) {
  */
 void simFullCircuit(Circuit* myCircuit) {
   for (int i=0; i<myCircuit->getNumberGates(); i++) {
-    Gate* g = myCircuit->getGate(i);
-    if (g->get_gateType() != GATE_PI)
-      g->setValue(LOGIC_UNSET);      
+    if (myCircuit->getGateType(i) != GATE_PI)
+      gateValues[i] = LOGIC_UNSET;      
   }  
-  vector<Gate*> circuitPOs = myCircuit->getPOGates();
+  const vector<uint32_t>& circuitPOs = myCircuit->getPOIndices();
   for (int i=0; i < circuitPOs.size(); i++) {
-    simGateRecursive(circuitPOs[i]);
+    simGateRecursive(circuitPOs[i], myCircuit);
   }
 }
 
 
 
-// Recursive function to find and set the value on Gate* g.
+// Recursive function to find and set the value on gate g.
 // This function calls simGate and setValueCheckFault. 
 // Don't change this function.
-/** @brief Recursive function to find and set the value on Gate* g.
- * \param g The gate to simulate.
- * This function prepares Gate* g to to be simulated by recursing
+/** @brief Recursive function to find and set the value on gate g.
+ * \param g The index of the gate to simulate.
+ * This function prepares gate g to to be simulated by recursing
  * on its inputs (if needed).
  * 
  * Then it calls \a simGate(g) to calculate the new value.
@@ -374,20 +382,21 @@ void simFullCircuit(Circuit* myCircuit) {
  * 
  * \note Do not change this function. 
  */
-void simGateRecursive(Gate* g) {
+void simGateRecursive(int g, Circuit* myCircuit) {
 
   // If this gate has an already-set value, you are done.
-  if (g->getValue() != LOGIC_UNSET)
+  if (gateValues[g] != LOGIC_UNSET)
     return;
   
   // Recursively call this function on this gate's predecessors to
   // ensure that their values are known.
-  vector<Gate*> pred = g->get_gateInputs();
-  for (int i=0; i<pred.size(); i++) {
-    simGateRecursive(pred[i]);
+  const uint32_t* pred = myCircuit->getFanin(g);
+  int numPred = myCircuit->getFaninCount(g);
+  for (int i=0; i<numPred; i++) {
+    simGateRecursive(pred[i], myCircuit);
   }
   
-  char gateValue = simGate(g);
+  char gateValue = simGate(g, myCircuit);
 
   // After I have calculated this gate's value, check to see if a fault changes it and set.
   setValueCheckFault(g, gateValue);
@@ -400,44 +409,34 @@ void simGateRecursive(Gate* g) {
  * Please see the project handout for a description of what
  * we are doing here and why.
 
- * This function takes as input the Circuit* and a queue<Gate*>
- * indicating the remaining gates that need to be evaluated.
+ * This function takes as input the Circuit* and a LevelQueue
+ * holding the gates that need to be evaluated. The queue is empty
+ * when this function returns.
  */
-void eventDrivenSim(Circuit* myCircuit, queue<Gate*> q) {
+void eventDrivenSim(Circuit* myCircuit, LevelQueue &q) {
 
   // Basic idea: 
-  // - Keep a queue (input q) of gates whose output values may potentially change
+  // - Keep a levelized queue (input q) of gates whose output values may potentially change
   // - while there are still gates in the queue: 
-  //      - Pop a gate from this queue. Store its currently-set output value.
+  //      - Pop a gate from the lowest level in this queue. Store its currently-set output value.
   //      - Based on the gate's inputs, calculate its new output value. Note that you don't
   //        need to do this from scratch, you can use the simGate() function below.
   //      - Check to see if the new gate output value differs from the old one. If it does
   //        add its fanout gates on the queue  
-Gate* i;
+  // A gate's fanouts are always at a higher level than the gate, and the queue ignores
+  // a gate that is already scheduled, so each gate is evaluated at most once per call.
+	int i;
 	
-	char gatevalue, newgateval;
-	vector<Gate*> gatesv;
+	char gatevalue;
 	
-  while(!q.empty())
+  while((i = q.pop()) != -1)
 	{
-		i = q.front();
-			q.pop();
-		
-			gatevalue = i->getValue();
+			gatevalue = gateValues[i];
 			
-			newgateval = simGate(i);
-			setValueCheckFault(i, newgateval);
+			setValueCheckFault(i, simGate(i, myCircuit));
 
-			if(newgateval!=gatevalue) 
-			{	
-				gatesv = i->get_gateOutputs();
-			
-				for(int j=0; j<gatesv.size(); j++)
-				{
-					q.push(gatesv[j]);
-				}
-				gatesv.clear();
-			}
+			if(gateValues[i]!=gatevalue) 
+				q.pushFanouts(i);
 	}
 	return;
   
@@ -445,24 +444,25 @@ Gate* i;
 
 
 
-/** @brief Simulate the value of the given Gate.
+/** @brief Simulate the value of the given gate.
  *
- * This is a gate simulation function -- it will simulate the gate g
+ * This is a gate simulation function -- it will simulate the gate with index g
  * with its current input values and return the output value.
  * This function does not deal with the fault. (That comes later.)
  * \note You do not need to change this function.
  *
  */
-char simGate(Gate* g) {
+char simGate(int g, Circuit* myCircuit) {
   // For convenience, create a vector of the values of this
   // gate's inputs.
-  vector<Gate*> pred = g->get_gateInputs();
+  const uint32_t* pred = myCircuit->getFanin(g);
+  int numPred = myCircuit->getFaninCount(g);
   vector<char> inputVals;   
-  for (int i=0; i<pred.size(); i++) {
-    inputVals.push_back(pred[i]->getValue());      
+  for (int i=0; i<numPred; i++) {
+    inputVals.push_back(gateValues[pred[i]]);      
   }
 
-  char gateType = g->get_gateType();
+  char gateType = myCircuit->getGateType(g);
   char gateValue;
   // Now, set the value of this gate based on its logical function and its input values
   switch(gateType) {   
@@ -585,20 +585,21 @@ int LogicNot(int logicVal) {
   return LOGIC_UNSET;
 }
 
-/** @brief Set the value of Gate* g to value gateValue, accounting for any fault on g.
+/** @brief Set the value of gate g to value gateValue, accounting for any fault on g.
     \note You will not need to modify this.
  */
-void setValueCheckFault(Gate* g, char gateValue) {
-  if ((g->get_faultType() == FAULT_SA0) && (gateValue == LOGIC_ONE)) 
-  	g->setValue(LOGIC_D);
-  else if ((g->get_faultType() == FAULT_SA0) && (gateValue == LOGIC_DBAR)) 
-  	g->setValue(LOGIC_ZERO);
-  else if ((g->get_faultType() == FAULT_SA1) && (gateValue == LOGIC_ZERO)) 
-  	g->setValue(LOGIC_DBAR);
-  else if ((g->get_faultType() == FAULT_SA1) && (gateValue == LOGIC_D)) 
-  	g->setValue(LOGIC_ONE);
+void setValueCheckFault(int g, char gateValue) {
+  char f = (g == faultLocation) ? faultLocationType : NOFAULT;
+  if ((f == FAULT_SA0) && (gateValue == LOGIC_ONE)) 
+  	gateValues[g] = LOGIC_D;
+  else if ((f == FAULT_SA0) && (gateValue == LOGIC_DBAR)) 
+  	gateValues[g] = LOGIC_ZERO;
+  else if ((f == FAULT_SA1) && (gateValue == LOGIC_ZERO)) 
+  	gateValues[g] = LOGIC_DBAR;
+  else if ((f == FAULT_SA1) && (gateValue == LOGIC_D)) 
+  	gateValues[g] = LOGIC_ONE;
   else
-  	g->setValue(gateValue);
+  	gateValues[g] = gateValue;
 }
 
 // End of functions for circuit simulation
@@ -617,15 +618,14 @@ bool podemRecursion(Circuit* myCircuit) {
 
   // If D or D' is at an output, then return true
     char val;
-	queue<Gate*> queue; 
-	vector<Gate*> opGates = myCircuit->getPOGates();
+	const vector<uint32_t>& opGates = myCircuit->getPOIndices();
 	for (int i=0; i<opGates.size(); i++) {
-    val = opGates[i]->getValue();
+    val = gateValues[opGates[i]];
     if ((val == LOGIC_D) || (val == LOGIC_DBAR)) 
       return true;    
 	}
 
-   Gate* g;
+   int g;
    char v;  
 
   // Call the getObjective function. Store the result in g and v.    
@@ -635,7 +635,7 @@ bool podemRecursion(Circuit* myCircuit) {
 	///////////
 	if (obj == false ) return false;
 	
-  Gate* pi;
+  int pi;
   char piVal;
   
   // Call the backtrace function. Store the result in pi and piVal.
@@ -646,21 +646,13 @@ bool podemRecursion(Circuit* myCircuit) {
   // to make sure if there is a fault on the PI gate, it correctly gets set.
   
   setValueCheckFault(pi, piVal);
-  vector<Gate*> pigates;
-  
-  pigates.clear();
-  pigates = pi->get_gateOutputs();
-			
-			for(int j=0; j<pigates.size(); j++)
-			{
-				queue.push(pigates[j]);
-			}
+  eventQueue.pushFanouts(pi);
   
   // Now, determine the implications of the input you set by simulating 
   // the circuit by calling simFullCircuit(myCircuit);
   
   //simFullCircuit(myCircuit);
-   eventDrivenSim(myCircuit, queue);
+   eventDrivenSim(myCircuit, eventQueue);
    
   // pi->printGateInfo();
   //faultLocation->printGateInfo();
@@ -673,32 +665,18 @@ bool podemRecursion(Circuit* myCircuit) {
   notpiVal= LogicNot(piVal);
   
   setValueCheckFault(pi, notpiVal); 
-  
-  pigates.clear();
-  pigates = pi->get_gateOutputs();
-			
-			for(int j=0; j<pigates.size(); j++)
-			{
-				queue.push(pigates[j]);
-			}
+  eventQueue.pushFanouts(pi);
   
   //simFullCircuit(myCircuit);
-  eventDrivenSim(myCircuit, queue);
+  eventDrivenSim(myCircuit, eventQueue);
   if (podemRecursion(myCircuit)) return true;
   
   // If we get to here, neither pi=v nor pi = v' worked. So, set pi to value X and 
   // return false.
   
   setValueCheckFault(pi, LOGIC_X);
-  
-   pigates.clear();
-  pigates = pi->get_gateOutputs();
-			
-			for(int j=0; j<pigates.size(); j++)
-			{
-				queue.push(pigates[j]);
-			}
-  eventDrivenSim(myCircuit, queue);
+  eventQueue.pushFanouts(pi);
+  eventDrivenSim(myCircuit, eventQueue);
 
   return false;
 
@@ -709,17 +687,17 @@ bool podemRecursion(Circuit* myCircuit) {
 // TODO Write this function, based on the pseudocode from
 // class or your textbook.
 /** @brief PODEM objective function.
- *  \param g Use this pointer to store the objective Gate your function picks.
+ *  \param g Use this to store the index of the objective gate your function picks.
  *  \param v Use this char to store the objective value your function picks.
  *  \returns True if the function is able to determine an objective, and false if it fails.
  * \note For Part 2, you must write this, following the pseudocode in class and the code's comments.
  */
 
-bool getObjective(Gate* &g, char &v, Circuit* myCircuit) {
+bool getObjective(int &g, char &v, Circuit* myCircuit) {
 
   // First you will need to check if the fault is activated yet.
   // Note that in the setup above we set up a global variable
-  // Gate* faultLocation which represents the gate with the stuck-at
+  // int faultLocation which represents the gate with the stuck-at
   // fault on its output. Use that when you check if the fault is
   // excited.
 
@@ -729,12 +707,12 @@ bool getObjective(Gate* &g, char &v, Circuit* myCircuit) {
   // the fault. In this case getObjective should fail and Return false.  
 	//cout<<"123";
 	
-	if (faultLocation->getValue()== LOGIC_X) {g= faultLocation; v=faultActivationVal; 
+	if (gateValues[faultLocation]== LOGIC_X) {g= faultLocation; v=faultActivationVal; 
 		return true;}
 	
-	if (faultLocation->getValue()== LOGIC_ONE || faultLocation->getValue()== LOGIC_ZERO)
+	if (gateValues[faultLocation]== LOGIC_ONE || gateValues[faultLocation]== LOGIC_ZERO)
 	{return false;} 
-	//setValueCheckFault(faultLocation, faultLocation->getValue());
+	//setValueCheckFault(faultLocation, gateValues[faultLocation]);
 
  
   
@@ -745,7 +723,7 @@ bool getObjective(Gate* &g, char &v, Circuit* myCircuit) {
   updateDFrontier(myCircuit);
 
   // This function should update the global D-frontier variable
-  // vector<Gate*> dFrontier;
+  // vector<int> dFrontier;
   
   // If the D frontier is empty after update, then getObjective fails
   // and should return false.
@@ -756,7 +734,7 @@ bool getObjective(Gate* &g, char &v, Circuit* myCircuit) {
 	
   // getObjective needs to choose a gate from the D-Frontier.
   // For part 1, pick dFrontier[0] if you want to match my reference outputs.
-	Gate* d;	
+	int d;	
 	d = dFrontier[0];
 	//if (t==1) {d->printGateInfo();exit(1);}
 	// Later, a possible optimization is to use the 
@@ -767,22 +745,24 @@ bool getObjective(Gate* &g, char &v, Circuit* myCircuit) {
   // gate you chose from the D-Frontier.
 
 	
-	vector<Gate*> dinputs = d->get_gateInputs();
+	const uint32_t* dinputs = myCircuit->getFanin(d);
+	int numDinputs = myCircuit->getFaninCount(d);
 	
 	
 	
 	
-		for (int i=0; i<dinputs.size(); i++) 
+		for (int i=0; i<numDinputs; i++) 
 			{
-				if (dinputs[i]->getValue()== LOGIC_X)
+				if (gateValues[dinputs[i]]== LOGIC_X)
 				{
 					g = dinputs[i]; break;
 				}
 			}
 		
-	if (d->get_gateType()==GATE_AND || d->get_gateType()==GATE_NAND) v=LOGIC_ONE;
-	else if (d->get_gateType()==GATE_OR || d->get_gateType()==GATE_NOR) v=LOGIC_ZERO;
-	else if (d->get_gateType()==GATE_XOR || d->get_gateType()==GATE_XNOR) v=LOGIC_ZERO;
+	char dType = myCircuit->getGateType(d);
+	if (dType==GATE_AND || dType==GATE_NAND) v=LOGIC_ONE;
+	else if (dType==GATE_OR || dType==GATE_NOR) v=LOGIC_ZERO;
+	else if (dType==GATE_XOR || dType==GATE_XNOR) v=LOGIC_ZERO;
 	else v=LOGIC_X;
 	
 	
@@ -807,19 +787,18 @@ void updateDFrontier(Circuit* myCircuit) {
   //  - loop over all gates in the circuit; for each gate, check if it should be on D-frontier; if it is,
   //    add it to the dFrontier vector.
 
-	Gate* G;
 	int numberofgates = myCircuit->getNumberGates();
 	
-	for (int i=0; i< numberofgates; i++)
+	for (int G=0; G< numberofgates; G++)
 	{
-		G = myCircuit->getGate(i);
-		if (G->getValue() != LOGIC_X) continue;
+		if (gateValues[G] != LOGIC_X) continue;
 		else
 		{
-			vector<Gate*> Ginputs = G->get_gateInputs(); 
-			for (int j=0; j<Ginputs.size(); j++) 
+			const uint32_t* Ginputs = myCircuit->getFanin(G); 
+			int numGinputs = myCircuit->getFaninCount(G);
+			for (int j=0; j<numGinputs; j++) 
 				{ 
-					if (Ginputs[j]->getValue()== LOGIC_D || Ginputs[j]->getValue() == LOGIC_DBAR)
+					if (gateValues[Ginputs[j]]== LOGIC_D || gateValues[Ginputs[j]] == LOGIC_DBAR)
 					{
 						dFrontier.push_back(G); break;
 					}
@@ -839,35 +818,36 @@ void updateDFrontier(Circuit* myCircuit) {
 // TODO: write this
 
 /** @brief PODEM backtrace function
- * \param pi Output: A Gate pointer to the primary input your backtrace function found.
+ * \param pi Output: The index of the primary input your backtrace function found.
  * \param piVal Output: The value you want to set that primary input to
- * \param objGate Input: The objective Gate (computed by getObjective)
+ * \param objGate Input: The index of the objective gate (computed by getObjective)
  * \param objVal Input: the objective value (computed by getObjective)
  * \note Write this function based on the psuedocode from class.
  */
-void backtrace(Gate* &pi, char &piVal, Gate* objGate, char objVal, Circuit* myCircuit) {
+void backtrace(int &pi, char &piVal, int objGate, char objVal, Circuit* myCircuit) {
 
 	pi = objGate;int k1;int cnt=0;
 	int num_inversions;
-	char gatetype = pi->get_gateType();
+	char gatetype = myCircuit->getGateType(pi);
 	
 	if (gatetype == GATE_NOR || gatetype == GATE_NOT || gatetype == GATE_NAND || gatetype == GATE_XNOR)
 		num_inversions=1;
 	else num_inversions=0;
 	
 	
-	while (pi->get_gateType()!=GATE_PI)
+	while (myCircuit->getGateType(pi)!=GATE_PI)
 	{ 
-		vector<Gate*> gateinputs = pi->get_gateInputs();//
+		const uint32_t* gateinputs = myCircuit->getFanin(pi);//
+		int numGateinputs = myCircuit->getFaninCount(pi);
 		
 		
-		for (k1=0; k1<gateinputs.size(); k1++) 
+		for (k1=0; k1<numGateinputs; k1++) 
 			{ 
-				if (gateinputs[k1]->getValue()== LOGIC_X) {pi=gateinputs[k1]; break;} 
+				if (gateValues[gateinputs[k1]]== LOGIC_X) {pi=gateinputs[k1]; break;} 
 				
 			}
 			
-			gatetype = pi->get_gateType();
+			gatetype = myCircuit->getGateType(pi);
 		if (gatetype == GATE_NOR || gatetype == GATE_NOT || gatetype == GATE_NAND || gatetype == GATE_XNOR)
 		{num_inversions++; }
 	}
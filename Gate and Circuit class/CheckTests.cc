@@ -0,0 +1,238 @@
+/** @file CheckTests.cc
+ * @brief Checks an ATPG output file: every test in it must detect its fault.
+ *
+ * Usage: ./checktests circuit_file fault_file output_file [reference_output] [--patterns F]
+ *
+ * The circuit is read like the ATPG reads it: a .v file as structural Verilog, anything else as .bench.
+ *
+ * The output has one line per fault of fault_file: a test (one 0, 1 or X per PI), "none found"
+ * or "aborted". Each test is simulated, in three-valued logic, in the good circuit and with
+ * its fault; it detects the fault if some PO is 0 in one and 1 in the other, so a test whose
+ * X's matter is not accepted. The simulation is written out here, on the compiled circuit,
+ * rather than taken from AtpgEngine or FaultSim, so that it checks them.
+ *
+ * With a reference output, a fault must be untestable ("none found") in both or in neither.
+ * The tests themselves may differ: any test that detects the fault is correct.
+ *
+ * With --patterns, F is a pattern set (e.g. from --static-compaction), one pattern per line:
+ * every fault that has a test in the output must also be detected by one of the patterns.
+ *
+ * Prints one line per problem and a summary, and exits with 1 if there was a problem.
+ * Build with "make checktests"; "make check" runs it on every test circuit in several modes.
+ */
+
+#include "ClassCircuit.h"
+#include "ClassBenchParser.h"
+#include "ClassVerilogParser.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+using namespace std;
+
+// Three-valued logic for the check (independent of the LOGIC_* values)
+#define CHECK_ZERO 0
+#define CHECK_ONE  1
+#define CHECK_X    2
+
+/** @brief Evaluate a gate of type \a type on three-valued inputs. */
+char checkEval(char type, const vector<char>& values, const uint32_t* fanin, int n) {
+  if ((type == GATE_BUFF) || (type == GATE_FANOUT))
+    return values[fanin[0]];
+  if (type == GATE_NOT)
+    return (values[fanin[0]] == CHECK_X) ? CHECK_X : 1 - values[fanin[0]];
+
+  bool inverting = (type == GATE_NAND) || (type == GATE_NOR) || (type == GATE_XNOR);
+  char r;
+  if ((type == GATE_XOR) || (type == GATE_XNOR)) {
+    r = CHECK_ZERO;
+    for (int i=0; i<n; i++) {
+      if (values[fanin[i]] == CHECK_X)
+        return CHECK_X;
+      r ^= values[fanin[i]];
+    }
+  }
+  else {
+    char controlling = ((type == GATE_AND) || (type == GATE_NAND)) ? CHECK_ZERO : CHECK_ONE;
+    bool sawX = false;
+    r = 1 - controlling;
+    for (int i=0; i<n; i++) {
+      if (values[fanin[i]] == controlling) {
+        r = controlling;
+        break;
+      }
+      sawX |= (values[fanin[i]] == CHECK_X);
+    }
+    if ((r != controlling) && sawX)
+      return CHECK_X;
+  }
+  return inverting ? 1 - r : r;
+}
+
+/** @brief Simulate \a test, with gate \a faultGate stuck at \a faultValue (-1: no fault). */
+void checkSim(const Circuit* c, const string& test, int faultGate, char faultValue, vector<char>& values) {
+  const vector<uint32_t>& pis = c->getPIIndices();
+  const vector<uint32_t>& order = c->getLevelOrder();
+  values.assign(order.size(), CHECK_X);
+  for (int i=0; i<pis.size(); i++)
+    values[pis[i]] = (test[i] == '0') ? CHECK_ZERO : ((test[i] == '1') ? CHECK_ONE : CHECK_X);
+  for (int i=0; i<order.size(); i++) {
+    int g = order[i];
+    if (c->getGateType(g) != GATE_PI)
+      values[g] = checkEval(c->getGateType(g), values, c->getFanin(g), c->getFaninCount(g));
+    if (g == faultGate)
+      values[g] = faultValue;
+  }
+}
+
+/** @brief Read the lines of a file (without their line ends). */
+bool readLines(const char* file, vector<string>& lines) {
+  ifstream in(file);
+  if (!in.is_open())
+    return false;
+  string s;
+  while (getline(in, s)) {
+    if (!s.empty() && (s[s.size()-1] == '\r'))
+      s.erase(s.size()-1);
+    lines.push_back(s);
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  const char* patternFile = NULL;
+  if ((argc > 2) && (string(argv[argc-2]) == "--patterns")) {
+    patternFile = argv[argc-1];
+    argc -= 2;
+  }
+  if ((argc < 4) || (argc > 5)) {
+    cout << "Usage: ./checktests circuit_file fault_file output_file [reference_output] [--patterns F]" << endl;
+    return 1;
+  }
+
+  string circuitFile = argv[1], error;
+  Circuit* c;
+  if ((circuitFile.size() > 2) && (circuitFile.compare(circuitFile.size()-2, 2, ".v") == 0)) {
+    VerilogParser parser;
+    c = parser.parse(circuitFile);
+    error = parser.getError();
+  }
+  else {
+    BenchParser parser;
+    c = parser.parse(circuitFile);
+    error = parser.getError();
+  }
+  if (c == NULL) {
+    cout << "ERROR: " << error << endl;
+    return 1;
+  }
+  c->setupCircuit();
+
+  vector<string> faultLines, out, ref;
+  vector<string> patterns;
+  if (!readLines(argv[2], faultLines) || !readLines(argv[3], out) || ((argc == 5) && !readLines(argv[4], ref)) ||
+      ((patternFile != NULL) && !readLines(patternFile, patterns))) {
+    cout << "ERROR: Cannot read the fault, output, reference or pattern file" << endl;
+    return 1;
+  }
+
+  // the fault file is pairs of lines: gate name, then 0 or 1
+  vector<int> faultGate;
+  vector<char> faultValue;
+  vector<string> faultName;
+  for (int i=0; i+1<faultLines.size(); i+=2) {
+    if (faultLines[i].empty())
+      break;
+    int g = c->findGateIndexByName(faultLines[i]);
+    if (g < 0) {
+      cout << "ERROR: Cannot find fault location " << faultLines[i] << " in circuit" << endl;
+      return 1;
+    }
+    faultGate.push_back(g);
+    faultValue.push_back(atoi(faultLines[i+1].c_str()) ? CHECK_ONE : CHECK_ZERO);
+    faultName.push_back(faultLines[i] + " / " + faultLines[i+1]);
+  }
+
+  int numBad = 0, numTests = 0, numNone = 0, numAborted = 0;
+  if (out.size() != faultGate.size()) {
+    cout << "output has " << out.size() << " lines for " << faultGate.size() << " faults" << endl;
+    numBad++;
+  }
+  if (!ref.empty() && (ref.size() != faultGate.size())) {
+    cout << "reference output has " << ref.size() << " lines for " << faultGate.size() << " faults" << endl;
+    numBad++;
+  }
+
+  const vector<uint32_t>& pos = c->getPOIndices();
+  int numPIs = c->getPIIndices().size();
+  vector<char> good, bad;
+
+  // the good values of each pattern, for --patterns
+  vector< vector<char> > patternGood(patterns.size());
+  for (int p=0; p<patterns.size(); p++) {
+    if ((patterns[p].size() != numPIs) || (patterns[p].find_first_not_of("01X") != string::npos)) {
+      cout << "pattern " << p+1 << " is not a test for " << numPIs << " PIs: " << patterns[p] << endl;
+      numBad++;
+      patterns[p].assign(numPIs, 'X');
+    }
+    checkSim(c, patterns[p], -1, CHECK_X, patternGood[p]);
+  }
+  for (int f=0; (f<out.size()) && (f<faultGate.size()); f++) {
+    bool refNone = (f < ref.size()) && (ref[f] == "none found");
+    if (out[f] == "aborted") {
+      numAborted++;
+      continue;
+    }
+    if (out[f] == "none found") {
+      numNone++;
+      if (!ref.empty() && !refNone) {
+        cout << "fault " << faultName[f] << ": none found, but the reference has a test" << endl;
+        numBad++;
+      }
+      continue;
+    }
+
+    numTests++;
+    if ((out[f].size() != numPIs) || (out[f].find_first_not_of("01X") != string::npos)) {
+      cout << "fault " << faultName[f] << ": not a test for " << numPIs << " PIs: " << out[f] << endl;
+      numBad++;
+      continue;
+    }
+    if (refNone) {
+      cout << "fault " << faultName[f] << ": has a test, but the reference found none" << endl;
+      numBad++;
+    }
+    checkSim(c, out[f], -1, CHECK_X, good);
+    checkSim(c, out[f], faultGate[f], faultValue[f], bad);
+    bool detected = false;
+    for (int i=0; i<pos.size(); i++)
+      if ((good[pos[i]] != CHECK_X) && (bad[pos[i]] != CHECK_X) && (good[pos[i]] != bad[pos[i]]))
+        detected = true;
+    if (!detected) {
+      cout << "fault " << faultName[f] << ": not detected by " << out[f] << endl;
+      numBad++;
+    }
+
+    if (patternFile != NULL) {
+      detected = false;
+      for (int p=0; (p<patterns.size()) && !detected; p++) {
+        checkSim(c, patterns[p], faultGate[f], faultValue[f], bad);
+        for (int i=0; i<pos.size(); i++)
+          if ((patternGood[p][pos[i]] != CHECK_X) && (bad[pos[i]] != CHECK_X) && (patternGood[p][pos[i]] != bad[pos[i]]))
+            detected = true;
+      }
+      if (!detected) {
+        cout << "fault " << faultName[f] << ": not detected by any of the patterns" << endl;
+        numBad++;
+      }
+    }
+  }
+
+  cout << argv[3] << ": " << numTests << " tests, " << numNone << " none found, " << numAborted
+       << " aborted";
+  if (patternFile != NULL)
+    cout << ", " << patterns.size() << " patterns";
+  cout << ": " << (numBad ? "FAILED" : "ok") << endl;
+  return numBad ? 1 : 0;
+}
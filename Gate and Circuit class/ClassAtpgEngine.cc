@@ -0,0 +1,838 @@
+/** \class AtpgEngine
+ * \brief A PODEM test generator for single stuck-at faults.
+ *
+ * The engine keeps all of its search state (gate values, assignment trail, D-frontier,
+ * decision stack, current fault, and statistics) in its own members. It only reads the
+ * circuit, through the compiled form (see Circuit::getFanin()), and never touches the
+ * Gate objects. So several engines can share one circuit, each working on its own fault,
+ * at the same time (for example one per thread).
+ *
+ * Typical use: call \a generateTest() with a fault, and if it returns PODEM_TEST_FOUND,
+ * read the test from the PIs with \a getValue().
+ *
+ * With \a setSatFallback(), a fault PODEM gives up on is handed to a SatAtpg, which either
+ * finds a test (put on the PIs as if PODEM had found it) or proves the fault untestable.
+ *
+ * With \a setImplicationTable(), PODEM also uses implications found by static learning: a
+ * fault whose site is forced to the wrong value is not activated, and a gate with an input
+ * forced to its controlling value blocks the X-path (see learnedBlocked()).
+ */
+
+#include "ClassAtpgEngine.h"
+#include "ClassLogicKernel.h"
+#include "ClassDualRail.h"
+#include <algorithm> // fill
+#include <assert.h>  // assert
+
+/** \brief Construct an engine for a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+AtpgEngine::AtpgEngine(const Circuit* c) : satAtpg(c) {
+  circuit = c;
+  int n = c->getLevelOrder().size();
+  gateValues.assign(n, LOGIC_X);
+  dFrontierPos.assign(n, -1);
+  numDInputs.assign(n, 0);
+  xPathDead.assign(n, 0);
+  undoEpoch = 0;
+  learned = NULL;
+  coneMark.assign(n, 0);
+  coneEpoch = 0;
+  dualRail = false;
+  eventQueue.init(c);
+
+  faultLocation = -1;
+  faultLocationType = NOFAULT;
+  faultActivationVal = LOGIC_X;
+
+  backtrackLimit = -1;
+  timeLimit = -1;
+  decisionLimit = -1;
+  stopFlag = NULL;
+  satFallback = false;
+  satUsed = false;
+  numBacktracks = 0;
+  numDecisions = 0;
+  AtpgStats zero = {0, 0, 0, 0, 0, 0, 0, 0};
+  stats = zero;
+}
+
+/** \brief Set the number of backtracks allowed per fault before PODEM aborts (-1: no limit). */
+void AtpgEngine::setBacktrackLimit(long n) { backtrackLimit = n; }
+
+/** \brief Set the number of seconds allowed per fault before PODEM aborts (-1: no limit). */
+void AtpgEngine::setTimeLimit(double s) { timeLimit = s; }
+
+/** \brief Set the number of decisions allowed per fault before PODEM aborts (-1: no limit). */
+void AtpgEngine::setDecisionLimit(long n) { decisionLimit = n; }
+
+/** \brief Make PODEM abort as soon as \a *stop becomes true (checked at each backtrack).
+ *  Another thread can set it to cancel the search. NULL: never stop.
+ */
+void AtpgEngine::setStopFlag(const atomic<bool>* stop) { stopFlag = stop; }
+
+/** \brief Use the implications in \a table (shared, not copied; NULL for none) in PODEM. */
+void AtpgEngine::setImplicationTable(const ImplicationTable* table) { learned = table; }
+
+/** \brief Evaluate gates with the dual-rail bitwise operations (see DualRail) instead of the
+ *  LogicKernel tables. Both give the same values. */
+void AtpgEngine::setDualRail(bool on) { dualRail = on; }
+
+/** \brief Give the faults PODEM cannot settle to the SAT engine.
+ *  \param decisions PODEM gives up on a fault once it has made this many decisions (-1: only
+ *  the backtrack and time limits apply)
+ *  \param conflicts Solver conflicts allowed per fault (-1: no limit)
+ */
+void AtpgEngine::setSatFallback(long decisions, long conflicts) {
+  satFallback = true;
+  decisionLimit = decisions;
+  satAtpg.setConflictLimit(conflicts);
+}
+
+/** \brief Run PODEM for one stuck-at fault.
+ *  \param g The gate whose output is faulty
+ *  \param type FAULT_SA0 or FAULT_SA1
+ *  \returns PODEM_TEST_FOUND (the test is left on the PIs, see getValue()),
+ *  PODEM_NO_TEST, or PODEM_ABORTED. getSatUsed() tells if the SAT engine decided it.
+ */
+int AtpgEngine::generateTest(int g, char type) {
+
+  // set up the fault we are trying to detect
+  setFault(g, type);
+  clearValues();
+
+  int res = podem();
+  satUsed = false;
+  if ((res == PODEM_ABORTED) && satFallback) {
+    stats.satCalls++;
+    res = satTest(g, type);
+    satUsed = true;
+    if (res != PODEM_ABORTED)
+      stats.satSolved++;
+  }
+
+  stats.faults++;
+  if (res == PODEM_TEST_FOUND)
+    stats.testsFound++;
+  else if (res == PODEM_NO_TEST)
+    stats.untestable++;
+  else
+    stats.aborted++;
+  stats.decisions += numDecisions;
+  stats.backtracks += numBacktracks;
+
+  return res;
+}
+
+/** \brief Carry on with the search of the last generateTest(), after PODEM aborted it.
+ *  \returns As generateTest() (the SAT fallback is not tried again)
+ *
+ * PODEM aborts at a backtrack, with its decisions and values in place; this takes that
+ * backtrack and goes on searching, under the limits set now (e.g. a higher decision limit, see
+ * setDecisionLimit()). The decision and backtrack counts and the time go on from where they
+ * were. The fault is still counted once in getStats(), with the new result.
+ * Call it only right after generateTest() returned PODEM_ABORTED with getSatUsed() false.
+ */
+int AtpgEngine::resumeTest() {
+  assert(!decisionStack.empty() && !decisionStack.back().flipped);
+  long decisions = numDecisions;
+  long backtracks = numBacktracks;
+
+  flipDecision();
+  int res = podemSearch();
+
+  stats.aborted--;
+  if (res == PODEM_TEST_FOUND)
+    stats.testsFound++;
+  else if (res == PODEM_NO_TEST)
+    stats.untestable++;
+  else
+    stats.aborted++;
+  stats.decisions += numDecisions - decisions;
+  stats.backtracks += numBacktracks - backtracks;
+  return res;
+}
+
+/** \brief Start from a partly specified test, for extendTest().
+ *  \param piValues One value (LOGIC_ZERO, LOGIC_ONE or LOGIC_X) per PI, in the order of Circuit::getPIIndices()
+ *
+ * This sets the PIs to \a piValues and simulates them, with no fault in the circuit.
+ */
+void AtpgEngine::setTestCube(const vector<char>& piValues) {
+  setTest(-1, NOFAULT, piValues);
+}
+
+/** \brief Try to extend the current test so it also detects another fault.
+ *  \param g The gate whose output is faulty
+ *  \param type FAULT_SA0 or FAULT_SA1
+ *  \param budget The number of backtracks allowed
+ *  \returns PODEM_TEST_FOUND if PODEM found a test for the fault by only assigning PIs that are
+ *  still X (see setTestCube()). The new assignments are then kept, and the values of all PIs can
+ *  be read with getValue(). Otherwise the test is left as it was.
+ *
+ * Only the fault's effect on the current values is simulated; after the search, the trail takes
+ * the circuit back to the fault-free values of the (possibly extended) test.
+ */
+int AtpgEngine::extendTest(int g, char type, long budget) {
+  int mark = trail.size();
+
+  // inject the fault into the current values
+  setFault(g, type);
+  char v = gateValues[g];
+  if (v != LOGIC_X) {
+    setValueCheckFault(g, v);
+    eventQueue.pushFanouts(g);
+    eventDrivenSim(eventQueue);
+  }
+
+  long limit = backtrackLimit;
+  backtrackLimit = budget;
+  int res = podem();
+  backtrackLimit = limit;
+
+  // the PI values of the extended test (good-machine values)
+  const vector<uint32_t>& pis = circuit->getPIIndices();
+  vector<char> piValues(pis.size());
+  for (int i=0; i<pis.size(); i++) {
+    char pv = gateValues[pis[i]];
+    if (pv == LOGIC_D)
+      pv = LOGIC_ONE;
+    else if (pv == LOGIC_DBAR)
+      pv = LOGIC_ZERO;
+    piValues[i] = pv;
+  }
+
+  // take out the fault and everything PODEM did
+  undoTrail(mark);
+  setFault(-1, NOFAULT);
+
+  // keep the new PI assignments
+  if (res == PODEM_TEST_FOUND) {
+    for (int i=0; i<pis.size(); i++) {
+      if (gateValues[pis[i]] != piValues[i]) {
+        setValueCheckFault(pis[i], piValues[i]);
+        eventQueue.pushFanouts(pis[i]);
+      }
+    }
+    eventDrivenSim(eventQueue);
+  }
+  return res;
+}
+
+/** \brief Run the SAT engine on the current fault, after PODEM gave up.
+ *  \returns PODEM_TEST_FOUND (the test is simulated, with the fault, like a PODEM test),
+ *  PODEM_NO_TEST, or PODEM_ABORTED if the solver hit its conflict limit.
+ */
+int AtpgEngine::satTest(int g, char type) {
+  int r = satAtpg.generateTest(g, type);
+  if (r == SAT_UNSAT)
+    return PODEM_NO_TEST;
+  if (r == SAT_UNKNOWN)
+    return PODEM_ABORTED;
+
+  setTest(g, type, satAtpg.getTest());
+  return PODEM_TEST_FOUND;
+}
+
+/** \brief Put a test found some other way (e.g. by a SatAtpg) on the PIs.
+ *  \param g The gate whose output is faulty
+ *  \param type FAULT_SA0 or FAULT_SA1
+ *  \param piValues One value (LOGIC_ZERO, LOGIC_ONE or LOGIC_X) per PI, in the order of Circuit::getPIIndices()
+ *
+ * The test is simulated with the fault in the circuit, so afterwards getValue() reads it as if
+ * generateTest() had found it.
+ */
+void AtpgEngine::setTest(int g, char type, const vector<char>& piValues) {
+  setFault(g, type);
+  clearValues();
+
+  const vector<uint32_t>& pis = circuit->getPIIndices();
+  for (int i=0; i<pis.size(); i++) {
+    if (piValues[i] != LOGIC_X) {
+      setValueCheckFault(pis[i], piValues[i]);
+      eventQueue.pushFanouts(pis[i]);
+    }
+  }
+  eventDrivenSim(eventQueue);
+}
+
+/** \brief Set the fault PODEM works on (\a g == -1 for no fault). */
+void AtpgEngine::setFault(int g, char type) {
+  faultLocation = g;
+  faultLocationType = type;
+  faultActivationVal = (type == FAULT_SA0) ? LOGIC_ONE : LOGIC_ZERO;
+
+  // learnedBlocked() needs to know which gates can carry the fault effect
+  if (learned && (g >= 0)) {
+    coneEpoch++;
+    coneMark[g] = coneEpoch;
+    coneStack.assign(1, g);
+    while (!coneStack.empty()) {
+      int h = coneStack.back();
+      coneStack.pop_back();
+      const uint32_t* fo = circuit->getFanout(h);
+      for (int j=0; j<circuit->getFanoutCount(h); j++) {
+        if (coneMark[fo[j]] != coneEpoch) {
+          coneMark[fo[j]] = coneEpoch;
+          coneStack.push_back(fo[j]);
+        }
+      }
+    }
+  }
+}
+
+/** \brief Set all gate values to X, and clear the D frontier and the assignment trail. */
+void AtpgEngine::clearValues() {
+  // set all gate values to X
+  fill(gateValues.begin(), gateValues.end(), LOGIC_X);
+
+  // initialize the D frontier and the assignment trail.
+  // (With every gate at X, no gate has a D or D' input.)
+  dFrontier.clear();
+  fill(dFrontierPos.begin(), dFrontierPos.end(), -1);
+  fill(numDInputs.begin(), numDInputs.end(), 0);
+  trail.clear();
+  undoEpoch++;
+}
+
+/** \brief Get the number of backtracks made for the last fault. */
+long AtpgEngine::getNumBacktracks() const { return numBacktracks; }
+
+/** \brief Get the number of decisions made for the last fault. */
+long AtpgEngine::getNumDecisions() const { return numDecisions; }
+
+/** \brief Returns true if the last result of generateTest() came from the SAT engine. */
+bool AtpgEngine::getSatUsed() const { return satUsed; }
+
+/** \brief Get the totals over all faults given to generateTest(). */
+const AtpgStats& AtpgEngine::getStats() const { return stats; }
+
+
+//////////////////////////////////////////////////////////////////////
+// Start of functions for circuit simulation.
+
+
+
+/** @brief Runs full circuit simulation
+ *
+ * Full-circuit simulation: set all non-PI gates to LOGIC_UNSET
+ * and call the recursive simulate function on all PO gates.
+ */
+void AtpgEngine::simFullCircuit() {
+  for (int i=0; i<(int)gateValues.size(); i++) {
+    if (circuit->getGateType(i) != GATE_PI)
+      gateValues[i] = LOGIC_UNSET;      
+  }  
+  const vector<uint32_t>& circuitPOs = circuit->getPOIndices();
+  for (int i=0; i < circuitPOs.size(); i++) {
+    simGateRecursive(circuitPOs[i]);
+  }
+}
+
+
+
+// Recursive function to find and set the value on gate g.
+// This function calls simGate and setValueCheckFault. 
+// Don't change this function.
+/** @brief Recursive function to find and set the value on gate g.
+ * \param g The index of the gate to simulate.
+ * This function prepares gate g to to be simulated by recursing
+ * on its inputs (if needed).
+ * 
+ * Then it calls \a simGate(g) to calculate the new value.
+ * 
+ * Lastly, it will set the Gate's output value based on
+ * the calculated value.
+ * 
+ * \note Do not change this function. 
+ */
+void AtpgEngine::simGateRecursive(int g) {
+
+  // If this gate has an already-set value, you are done.
+  if (gateValues[g] != LOGIC_UNSET)
+    return;
+  
+  // Recursively call this function on this gate's predecessors to
+  // ensure that their values are known.
+  const uint32_t* pred = circuit->getFanin(g);
+  int numPred = circuit->getFaninCount(g);
+  for (int i=0; i<numPred; i++) {
+    simGateRecursive(pred[i]);
+  }
+  
+  char gateValue = simGate(g);
+
+  // After I have calculated this gate's value, check to see if a fault changes it and set.
+  setValueCheckFault(g, gateValue);
+}
+
+
+/** @brief Perform event-driven simulation.
+ *
+ * This function takes as input a LevelQueue
+ * holding the gates that need to be evaluated. The queue is empty
+ * when this function returns.
+ */
+void AtpgEngine::eventDrivenSim(LevelQueue &q) {
+
+  // Basic idea: 
+  // - Keep a levelized queue (input q) of gates whose output values may potentially change
+  // - while there are still gates in the queue: 
+  //      - Pop a gate from the lowest level in this queue. Store its currently-set output value.
+  //      - Based on the gate's inputs, calculate its new output value. Note that you don't
+  //        need to do this from scratch, you can use the simGate() function below.
+  //      - Check to see if the new gate output value differs from the old one. If it does
+  //        add its fanout gates on the queue  
+  // A gate's fanouts are always at a higher level than the gate, and the queue ignores
+  // a gate that is already scheduled, so each gate is evaluated at most once per call.
+	int i;
+	
+	char gatevalue;
+	
+  while((i = q.pop()) != -1)
+	{
+			gatevalue = gateValues[i];
+			
+			setValueCheckFault(i, simGate(i));
+
+			if(gateValues[i]!=gatevalue) 
+				q.pushFanouts(i);
+	}
+	return;
+  
+}
+
+
+
+/** @brief Simulate the value of the given gate.
+ *
+ * This is a gate simulation function -- it will simulate the gate with index g
+ * with its current input values and return the output value.
+ * This function does not deal with the fault. (That comes later.)
+ * The fanin values are read in place by the table-driven LogicKernel, or by the
+ * dual-rail kernel if setDualRail() was called.
+ *
+ */
+char AtpgEngine::simGate(int g) {
+  char gateType = circuit->getGateType(g);
+  if (gateType == GATE_PI) {
+    cout << "ERROR: Do not know how to evaluate gate type " << gateType << endl;
+    assert(false);
+  }
+  if (dualRail)
+    return DualRail::evalLogicGate(gateType, &gateValues[0], circuit->getFanin(g), circuit->getFaninCount(g));
+  return LogicKernel::evalGate(gateType, &gateValues[0], circuit->getFanin(g), circuit->getFaninCount(g));
+}
+
+/** @brief Set the value of gate g to value gateValue, accounting for any fault on g.
+ *  If this changes the gate's value, the old value is logged on the trail
+ *  and the D-frontier is updated.
+ */
+void AtpgEngine::setValueCheckFault(int g, char gateValue) {
+  char f = (g == faultLocation) ? faultLocationType : NOFAULT;
+  if ((f == FAULT_SA0) && (gateValue == LOGIC_ONE)) 
+  	gateValue = LOGIC_D;
+  else if ((f == FAULT_SA0) && (gateValue == LOGIC_DBAR)) 
+  	gateValue = LOGIC_ZERO;
+  else if ((f == FAULT_SA1) && (gateValue == LOGIC_ZERO)) 
+  	gateValue = LOGIC_DBAR;
+  else if ((f == FAULT_SA1) && (gateValue == LOGIC_D)) 
+  	gateValue = LOGIC_ONE;
+
+  if (gateValues[g] != gateValue) {
+  	char oldVal = gateValues[g];
+  	trail.push_back(make_pair(g, oldVal));
+  	gateValues[g] = gateValue;
+  	updateDFrontier(g, oldVal);
+  }
+}
+
+/** @brief Undo every value change logged on the trail after position mark.
+ *  \param mark A trail position, taken with trail.size() before the changes to undo.
+ *  This restores exactly the gate values (and so the D-frontier) that existed
+ *  when mark was taken, in time proportional to the number of changes.
+ */
+void AtpgEngine::undoTrail(int mark) {
+  if (trail.size() > mark)
+  	undoEpoch++;
+  while (trail.size() > mark) {
+  	int g = trail.back().first;
+  	char oldVal = gateValues[g];
+  	gateValues[g] = trail.back().second;
+  	trail.pop_back();
+  	updateDFrontier(g, oldVal);
+  }
+}
+
+// End of functions for circuit simulation
+////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////
+// Begin functions for PODEM.
+
+/** @brief PODEM search for the current fault.
+ *
+ * This is the PODEM recursion, written as a loop over an explicit stack of
+ * decisions (decisionStack) so that the search depth is not limited by the C++ stack.
+ * At each step we either make a new decision (objective + backtrace), or, if the
+ * current assignment cannot lead to a test, backtrack: undo the most recent decision
+ * whose other value has not been tried yet, and try that value.
+ *
+ * \returns PODEM_TEST_FOUND (the test is left in gateValues), PODEM_NO_TEST if the
+ * whole search space was explored, or PODEM_ABORTED if backtrackLimit, decisionLimit or timeLimit
+ * was reached first (or the stop flag was set).
+ */
+int AtpgEngine::podem() {
+
+	decisionStack.clear();
+	numBacktracks = 0;
+	numDecisions = 0;
+	faultStartTime = chrono::steady_clock::now();
+	return podemSearch();
+}
+
+/** @brief The PODEM search loop, from the current decisions (see podem()). */
+int AtpgEngine::podemSearch() {
+	while (true) {
+	
+		// If D or D' is at an output, then we have a test.
+		if (faultEffectAtPO())
+			return PODEM_TEST_FOUND;
+		
+		// If the fault effect can still reach a PO through X-valued gates,
+		// and getObjective finds an objective, make a new decision.
+		int g;
+		char v;
+		if (xPathCheck() && getObjective(g, v)) {
+			int pi;
+			char piVal;
+			backtrace(pi, piVal, g, v);
+			
+			Decision d = { pi, piVal, (int)trail.size(), false };
+			decisionStack.push_back(d);
+			numDecisions++;
+			assignPI(pi, piVal);
+			continue;
+		}
+		
+		// Otherwise, this assignment cannot lead to a test: backtrack.
+		// Undo decisions whose other value was already tried, until we find
+		// one whose other value was not.
+		while (!decisionStack.empty() && decisionStack.back().flipped) {
+			undoTrail(decisionStack.back().mark);
+			decisionStack.pop_back();
+		}
+		
+		if (decisionStack.empty())
+			return PODEM_NO_TEST;
+		
+		numBacktracks++;
+		if (limitReached())
+			return PODEM_ABORTED;
+		
+		flipDecision();
+	}
+}
+
+/** @brief Backtrack: try the other value of the most recent decision (its first value failed). */
+void AtpgEngine::flipDecision() {
+	Decision &d = decisionStack.back();
+	undoTrail(d.mark);
+	d.val = LogicKernel::logicNot(d.val);
+	d.flipped = true;
+	assignPI(d.pi, d.val);
+}
+
+/** @brief Returns true if any PO has the value D or D'. */
+bool AtpgEngine::faultEffectAtPO() {
+	const vector<uint32_t>& opGates = circuit->getPOIndices();
+	for (int i=0; i<opGates.size(); i++) {
+		char val = gateValues[opGates[i]];
+		if ((val == LOGIC_D) || (val == LOGIC_DBAR)) 
+			return true;    
+	}
+	return false;
+}
+
+/** @brief Set PI pi to piVal and simulate its implications.
+ *
+ * Use setValueCheckFault so that if there is a fault on the PI gate, it correctly gets set.
+ * Only the gates downstream of pi can change, so we use the event-driven simulator
+ * starting from pi's fanouts.
+ */
+void AtpgEngine::assignPI(int pi, char piVal) {
+	setValueCheckFault(pi, piVal);
+	eventQueue.pushFanouts(pi);
+	eventDrivenSim(eventQueue);
+}
+
+/** @brief Returns true if PODEM should give up on the current fault.
+ *
+ * Called once per backtrack. Reading the clock is comparatively slow, so the
+ * time limit is only checked every 256 backtracks.
+ */
+bool AtpgEngine::limitReached() {
+	if ((backtrackLimit >= 0) && (numBacktracks > backtrackLimit))
+		return true;
+	
+	if ((decisionLimit >= 0) && (numDecisions > decisionLimit))
+		return true;
+	
+	if (stopFlag && stopFlag->load(memory_order_relaxed))
+		return true;
+	
+	if ((timeLimit >= 0) && ((numBacktracks & 255) == 0)) {
+		chrono::duration<double> elapsed = chrono::steady_clock::now() - faultStartTime;
+		if (elapsed.count() > timeLimit)
+			return true;
+	}
+	return false;
+}
+
+/** @brief PODEM objective function.
+ *  \param g Output: the index of the objective gate.
+ *  \param v Output: the objective value.
+ *  \returns True if the function is able to determine an objective, and false if it fails.
+ *
+ * While the fault is not excited, the objective is to set the fault location to the
+ * value that excites it. Once it is, the objective is to set an X input of a D-frontier
+ * gate to the gate's non-controlling value.
+ */
+bool AtpgEngine::getObjective(int &g, char &v) {
+
+	// The fault location is still X: excite the fault.
+	if (gateValues[faultLocation]== LOGIC_X) {g= faultLocation; v=faultActivationVal; 
+		return true;}
+	
+	// The fault location has a good value: the fault can no longer be excited.
+	if (gateValues[faultLocation]== LOGIC_ONE || gateValues[faultLocation]== LOGIC_ZERO)
+	{return false;} 
+
+	// The fault is excited; with an empty D-frontier its effect cannot reach a PO.
+	if (dFrontier.empty()) return false;
+	
+	
+  // We pick the D-frontier gate that is easiest to observe, i.e. the one with the
+  // lowest SCOAP observability (CO). dFrontier is not sorted, so ties
+  // go to the lowest-numbered gate to keep the choice deterministic.
+	int d;	
+	d = dFrontier[0];
+	for (int i=1; i<dFrontier.size(); i++)
+	{
+		int co = circuit->getCO(dFrontier[i]);
+		if ((co < circuit->getCO(d)) || ((co == circuit->getCO(d)) && (dFrontier[i] < d)))
+			d = dFrontier[i];
+	}
+    
+
+  // The objective is an X input of that gate, set to its non-controlling value.
+	
+	const uint32_t* dinputs = circuit->getFanin(d);
+	int numDinputs = circuit->getFaninCount(d);
+	
+		for (int i=0; i<numDinputs; i++) 
+			{
+				if (gateValues[dinputs[i]]== LOGIC_X)
+				{
+					g = dinputs[i]; break;
+				}
+			}
+			
+	char dType = circuit->getGateType(d);
+	if (dType==GATE_AND || dType==GATE_NAND) v=LOGIC_ONE;
+	else if (dType==GATE_OR || dType==GATE_NOR) v=LOGIC_ZERO;
+	else {
+		// A one-input gate with a D or D' input is never X, so it is never on the D-frontier.
+		assert(dType==GATE_XOR || dType==GATE_XNOR);
+		v=LOGIC_ZERO;
+	}
+	
+	
+  return true;
+
+}
+
+
+// Incrementally update the D frontier.
+/** @brief Update the D frontier after the value of gate g changed from oldVal.
+ *
+ * A gate is on the D-frontier when its value is X and at least one of its inputs
+ * is D or D'. When g changes, only g itself and its fanouts can join or leave
+ * the D-frontier, so only those are checked. numDInputs keeps the number of D/D'
+ * inputs of each gate, so each check takes constant time.
+ */
+void AtpgEngine::updateDFrontier(int g, char oldVal) {
+	char newVal = gateValues[g];
+	int wasD = (oldVal == LOGIC_D) || (oldVal == LOGIC_DBAR);
+	int isD = (newVal == LOGIC_D) || (newVal == LOGIC_DBAR);
+	
+	if (isD != wasD)
+	{
+		const uint32_t* fo = circuit->getFanout(g);
+		int numFo = circuit->getFanoutCount(g);
+		for (int j=0; j<numFo; j++)
+		{
+			numDInputs[fo[j]] += isD - wasD;
+			checkDFrontierGate(fo[j]);
+		}
+	}
+	
+	checkDFrontierGate(g);
+}
+
+/** @brief Add gate g to or remove it from the D frontier, based on its current value and inputs.
+ *
+ * The D-frontier is an indexed set: dFrontierPos gives each member's position in dFrontier,
+ * so both adding and removing (by swapping with the last element) take constant time.
+ */
+void AtpgEngine::checkDFrontierGate(int g) {
+	bool member = (gateValues[g] == LOGIC_X) && (numDInputs[g] > 0);
+	
+	if (member && (dFrontierPos[g] < 0))
+	{
+		dFrontierPos[g] = dFrontier.size();
+		dFrontier.push_back(g);
+	}
+	else if (!member && (dFrontierPos[g] >= 0))
+	{
+		int last = dFrontier.back();
+		dFrontier[dFrontierPos[g]] = last;
+		dFrontierPos[last] = dFrontierPos[g];
+		dFrontier.pop_back();
+		dFrontierPos[g] = -1;
+	}
+}
+
+
+/** @brief PODEM backtrace function: find a PI, and a value for it, that works towards
+ * the objective \a objVal on \a objGate.
+ * \param pi Output: The index of the primary input found.
+ * \param piVal Output: The value you want to set that primary input to
+ * \param objGate Input: The index of the objective gate (computed by getObjective)
+ * \param objVal Input: the objective value (computed by getObjective)
+ *
+ * At each gate on the way back to a PI, we choose which X input to follow using
+ * SCOAP controllability. If the value needed on the input is the gate's controlling
+ * value, one input is enough, so we follow the easiest input to set. Otherwise every
+ * input will have to be set, so we follow the hardest one first: if it cannot be set,
+ * we find out early.
+ */
+void AtpgEngine::backtrace(int &pi, char &piVal, int objGate, char objVal) {
+
+	pi = objGate;
+	char val = objVal;   // the value we want on the output of gate pi
+	
+	while (circuit->getGateType(pi)!=GATE_PI)
+	{ 
+		char gatetype = circuit->getGateType(pi);
+		
+		// value needed on the input we follow
+		if (gatetype == GATE_NOR || gatetype == GATE_NOT || gatetype == GATE_NAND || gatetype == GATE_XNOR)
+			val = LogicKernel::logicNot(val);
+		
+		bool easiest = true;
+		if (gatetype == GATE_AND || gatetype == GATE_NAND)
+			easiest = (val == LOGIC_ZERO);
+		else if (gatetype == GATE_OR || gatetype == GATE_NOR)
+			easiest = (val == LOGIC_ONE);
+		
+		const uint32_t* gateinputs = circuit->getFanin(pi);
+		int numGateinputs = circuit->getFaninCount(pi);
+		
+		int next = -1, nextCost = 0;
+		for (int k=0; k<numGateinputs; k++) 
+		{ 
+			if (gateValues[gateinputs[k]] != LOGIC_X) continue;
+			
+			int cost = (val == LOGIC_ONE) ? circuit->getCC1(gateinputs[k]) : circuit->getCC0(gateinputs[k]);
+			if ((next == -1) || (easiest && (cost < nextCost)) || (!easiest && (cost > nextCost)))
+			{
+				next = gateinputs[k];
+				nextCost = cost;
+			}
+		}
+		
+		// A gate whose output is X always has an X input.
+		assert(next != -1);
+		pi = next;
+	}
+	
+	piVal = val;
+	
+}
+
+
+// X-path check: can the fault effect still reach a PO?
+/** @brief Returns false if no fault effect can reach a PO through X-valued gates.
+ *
+ * If the fault is not activated yet, the fault site itself must have an X-path.
+ * If it is activated, at least one D-frontier gate must have one. If the fault site
+ * is already at the wrong value, this returns true and leaves the failure to getObjective().
+ */
+bool AtpgEngine::xPathCheck() {
+	char faultVal = gateValues[faultLocation];
+	
+	if (faultVal == LOGIC_X) {
+		if (learned && learned->isForced(faultLocation, LogicKernel::logicNot(faultActivationVal), gateValues))
+			return false;
+		return hasXPath(faultLocation);
+	}
+	
+	if ((faultVal != LOGIC_D) && (faultVal != LOGIC_DBAR))
+		return true;
+	
+	for (int i=0; i<dFrontier.size(); i++)
+		if (!learnedBlocked(dFrontier[i]) && hasXPath(dFrontier[i]))
+			return true;
+	
+	return false;
+}
+
+/** @brief Returns true if the X-valued gate g is a PO or has a path of X-valued gates to a PO.
+ *
+ * Assigning values never turns a gate back to X, so once we find that a gate has no X-path,
+ * it cannot get one again until something is undone. We cache that in xPathDead (stamped with
+ * undoEpoch), so every undo invalidates the cache at once, and while we only move forward
+ * (deeper in the search), each gate is explored at most once in total.
+ */
+bool AtpgEngine::hasXPath(int g) {
+	if (xPathDead[g] == undoEpoch)
+		return false;
+	
+	if (circuit->isPOGate(g))
+		return true;
+	
+	const uint32_t* fo = circuit->getFanout(g);
+	int numFo = circuit->getFanoutCount(g);
+	for (int j=0; j<numFo; j++)
+		if ((gateValues[fo[j]] == LOGIC_X) && !learnedBlocked(fo[j]) && hasXPath(fo[j]))
+			return true;
+	
+	xPathDead[g] = undoEpoch;
+	return false;
+}
+
+/** @brief Returns true if the learned implications show that X-valued gate g cannot pass on
+ *  the fault effect: an X input of g from outside the fault's cone (so it has the same value
+ *  in the good and faulty circuits) is forced to g's controlling value.
+ *  Always false without an ImplicationTable.
+ */
+bool AtpgEngine::learnedBlocked(int g) {
+	if (!learned)
+		return false;
+	
+	char c;
+	switch (circuit->getGateType(g)) {
+	case GATE_AND: case GATE_NAND: c = LOGIC_ZERO; break;
+	case GATE_OR: case GATE_NOR: c = LOGIC_ONE; break;
+	default: return false;
+	}
+	
+	const uint32_t* pred = circuit->getFanin(g);
+	int numPred = circuit->getFaninCount(g);
+	for (int i=0; i<numPred; i++)
+		if ((gateValues[pred[i]] == LOGIC_X) && (coneMark[pred[i]] != coneEpoch) && learned->isForced(pred[i], c, gateValues))
+			return true;
+	return false;
+}
@@ -0,0 +1,127 @@
+#ifndef CLASSATPGENGINE_H
+#define CLASSATPGENGINE_H
+
+#include "ClassCircuit.h"
+#include "ClassLevelQueue.h"
+#include "ClassSatAtpg.h"
+#include "ClassImplicationTable.h"
+#include <vector>    // vector
+#include <chrono>    // steady_clock
+#include <atomic>    // atomic
+using namespace std;
+
+// Results of a PODEM run (see AtpgEngine::generateTest())
+#define PODEM_TEST_FOUND 0   // a test was found
+#define PODEM_NO_TEST    1   // the search was exhausted: the fault is untestable
+#define PODEM_ABORTED    2   // the search hit the backtrack or time limit
+
+/** @brief One PODEM decision: PI pi was set to val. mark is the trail position before the
+ *  assignment, and flipped is true once the other value of pi has been tried. */
+struct Decision {
+  int pi;
+  char val;
+  int mark;
+  bool flipped;
+};
+
+/** @brief Counters kept by an AtpgEngine over all the faults it has worked on. */
+struct AtpgStats {
+  long faults;       // calls to generateTest()
+  long testsFound;   // ... that returned PODEM_TEST_FOUND
+  long untestable;   // ... that returned PODEM_NO_TEST
+  long aborted;      // ... that returned PODEM_ABORTED
+  long decisions;    // PODEM decisions, over all faults
+  long backtracks;   // PODEM backtracks, over all faults
+  long satCalls;     // faults PODEM aborted on that were given to the SAT engine
+  long satSolved;    // ... that it found a test for or proved untestable
+};
+
+class AtpgEngine{
+
+ private:
+  const Circuit* circuit;              // The circuit (shared, never modified)
+
+  vector<char> gateValues;             // The logic value of each gate's output, indexed by gate
+  vector< pair<int, char> > trail;     // Gates changed by setValueCheckFault() and their old values, for undoTrail()
+  LevelQueue eventQueue;               // Gates waiting to be evaluated by eventDrivenSim()
+  vector<int> dFrontier;               // The D-Frontier (in no particular order)
+  vector<int> dFrontierPos;            // Position of each gate in dFrontier, or -1 if it is not on the D-Frontier
+  vector<int> numDInputs;              // Number of inputs of each gate whose value is D or D'
+  int undoEpoch;                       // Counts calls to undoTrail() that undid something
+  vector<int> xPathDead;               // xPathDead[g] == undoEpoch means gate g has no X-path to a PO
+  const ImplicationTable* learned;     // Learned implications (NULL if none, see setImplicationTable())
+  vector<int> coneMark;                // With learned: coneMark[g] == coneEpoch if g is in the fault's fanout cone
+  int coneEpoch;                       // Counts calls to setFault() that marked a cone
+  vector<int> coneStack;               // Scratch list for marking the cone
+  bool dualRail;                       // If true, simGate() evaluates gates in the dual-rail encoding
+
+  int faultLocation;                   // The gate with the stuck-at fault on its output
+  char faultLocationType;              // The type of the stuck-at fault (FAULT_SA0 or FAULT_SA1)
+  char faultActivationVal;             // The value needed on faultLocation to activate the fault
+
+  vector<Decision> decisionStack;      // The PODEM decisions for the current fault
+  long backtrackLimit;                 // Backtracks allowed per fault before aborting (-1: no limit)
+  double timeLimit;                    // Seconds allowed per fault before aborting (-1: no limit)
+  long decisionLimit;                  // Decisions allowed per fault before PODEM gives up (-1: no limit)
+  const atomic<bool>* stopFlag;        // If set and true, PODEM gives up (see setStopFlag())
+  bool satFallback;                    // If true, faults PODEM aborts on are given to satAtpg
+  SatAtpg satAtpg;                     // The SAT engine
+  bool satUsed;                        // True if the SAT engine produced the last result
+  long numBacktracks;                  // Backtracks made so far for the current fault
+  long numDecisions;                   // Decisions made so far for the current fault
+  chrono::steady_clock::time_point faultStartTime; // When PODEM started on the current fault
+  AtpgStats stats;                     // Totals over all faults
+
+  void setFault(int g, char type);
+  void clearValues();
+
+  // circuit simulation
+  void simGateRecursive(int g);
+  void eventDrivenSim(LevelQueue &q);
+  char simGate(int g);
+  void setValueCheckFault(int g, char gateValue);
+  void undoTrail(int mark);
+
+  // PODEM
+  int podem();
+  int podemSearch();
+  void flipDecision();
+  bool faultEffectAtPO();
+  void assignPI(int pi, char piVal);
+  bool limitReached();
+  int satTest(int g, char type);
+  bool getObjective(int &g, char &v);
+  void updateDFrontier(int g, char oldVal);
+  void checkDFrontierGate(int g);
+  void backtrace(int &pi, char &piVal, int objGate, char objVal);
+  bool xPathCheck();
+  bool hasXPath(int g);
+  bool learnedBlocked(int g);
+
+ public:
+  AtpgEngine(const Circuit* c);
+
+  void setBacktrackLimit(long n);
+  void setTimeLimit(double s);
+  void setDecisionLimit(long n);
+  void setStopFlag(const atomic<bool>* stop);
+  void setSatFallback(long decisions, long conflicts);
+  void setImplicationTable(const ImplicationTable* table);
+  void setDualRail(bool on);
+
+  int generateTest(int g, char type);
+  int resumeTest();
+  void setTestCube(const vector<char>& piValues);
+  void setTest(int g, char type, const vector<char>& piValues);
+  int extendTest(int g, char type, long budget);
+  void simFullCircuit();
+
+  /** \brief Get the value of gate \a g (after generateTest(), the test is on the PIs). */
+  inline char getValue(int g) const { return gateValues[g]; }
+  long getNumBacktracks() const;
+  long getNumDecisions() const;
+  bool getSatUsed() const;
+  const AtpgStats& getStats() const;
+};
+
+#endif
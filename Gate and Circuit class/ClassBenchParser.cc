@@ -0,0 +1,267 @@
+/** \class BenchParser
+ * \brief Reads a circuit in ISCAS .bench format into a new Circuit.
+ *
+ * The file is memory-mapped and parsed in a single pass. Names are not copied out of the
+ * file one by one: each one is interned straight from the mapped text into the circuit's
+ * name table (see Circuit::internName()), and gates, their fanins and the outputs are passed
+ * to the circuit by name index as they are read. A signal may be used before the line that
+ * defines it.
+ *
+ * The format is the one the old flex/bison front end accepted:
+ *
+ *     # comment
+ *     INPUT(a)
+ *     OUTPUT(z)
+ *     z = NAND(a, b)
+ *
+ * with gate types NAND, NOR, AND, OR, XOR, XNOR, BUFF and NOT (in any case), and names made of
+ * letters, digits, '.' and '_'. The first error stops the parse and is reported with its line
+ * number (see getError()): syntax errors, unknown gate types, a NOT or BUFF without exactly one
+ * input, a signal defined twice, and a signal that is used but never defined.
+ */
+
+#include "ClassBenchParser.h"
+#include <sstream>     // ostringstream
+#include <string.h>    // strlen
+#include <strings.h>   // strncasecmp
+#include <fcntl.h>     // open
+#include <unistd.h>    // read, close
+#include <sys/mman.h>  // mmap, munmap, madvise
+#include <sys/stat.h>  // fstat
+
+// Keywords that are not gate types (see benchKeyword())
+#define BENCH_NOT_KEYWORD -1
+#define BENCH_INPUT       -2
+#define BENCH_OUTPUT      -3
+#define BENCH_DFF         -4
+
+/** \brief Returns true if \a c can be part of a signal name. */
+static inline bool isNameChar(char c) {
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '.') || (c == '_');
+}
+
+/** \brief Returns the GATE_* type (or BENCH_INPUT, BENCH_OUTPUT, BENCH_DFF) a word names,
+ *  ignoring case, or BENCH_NOT_KEYWORD. */
+static int benchKeyword(const char* s, int len) {
+  static const struct { const char* word; int value; } keywords[] = {
+    { "NAND", GATE_NAND }, { "NOR", GATE_NOR }, { "AND", GATE_AND }, { "OR", GATE_OR },
+    { "XOR", GATE_XOR }, { "XNOR", GATE_XNOR }, { "BUFF", GATE_BUFF }, { "NOT", GATE_NOT },
+    { "INPUT", BENCH_INPUT }, { "OUTPUT", BENCH_OUTPUT }, { "DFF", BENCH_DFF }
+  };
+  for (int i=0; i<sizeof(keywords)/sizeof(keywords[0]); i++)
+    if ((strlen(keywords[i].word) == len) && (strncasecmp(keywords[i].word, s, len) == 0))
+      return keywords[i].value;
+  return BENCH_NOT_KEYWORD;
+}
+
+/** \brief Construct a parser. */
+BenchParser::BenchParser() {
+  pos = end = NULL;
+  line = 0;
+  circuit = NULL;
+}
+
+/** \brief Get the first error found by the last parse() (empty if it succeeded),
+ *  as "file:line: message". */
+const string& BenchParser::getError() const { return error; }
+
+/** \brief Record an error (if it is the first one).
+ *  \param errLine The line it is on
+ *  \param msg What is wrong
+ *  \return false, so parse functions can "return fail(...)"
+ */
+bool BenchParser::fail(int errLine, const string& msg) {
+  if (error.empty()) {
+    ostringstream ss;
+    ss << fileName << ":" << errLine << ": " << msg;
+    error = ss.str();
+  }
+  return false;
+}
+
+/** \brief Skip white space and comments, counting lines. */
+void BenchParser::skipSpace() {
+  while (pos < end) {
+    char c = *pos;
+    if (c == '\n') {
+      line++;
+      pos++;
+    }
+    else if ((c == ' ') || (c == '\t') || (c == '\r'))
+      pos++;
+    else if (c == '#') {
+      while ((pos < end) && (*pos != '\n'))
+        pos++;
+    }
+    else
+      return;
+  }
+}
+
+/** \brief Read a name (after skipping white space).
+ *  \param s Output: the name's first character, in the file text
+ *  \param len Output: its length
+ *  \return false if there is no name here
+ */
+bool BenchParser::readName(const char* &s, int &len) {
+  skipSpace();
+  s = pos;
+  while ((pos < end) && isNameChar(*pos))
+    pos++;
+  len = pos - s;
+  return len > 0;
+}
+
+/** \brief Read the character \a c (after skipping white space); an error if it is not there. */
+bool BenchParser::expect(char c) {
+  skipSpace();
+  if ((pos < end) && (*pos == c)) {
+    pos++;
+    return true;
+  }
+  string found = (pos < end) ? string("'") + *pos + "'" : string("end of file");
+  return fail(line, string("expected '") + c + "' but found " + found);
+}
+
+/** \brief Get the circuit's name index for a name, noting the line where it first appears. */
+int BenchParser::nameIndex(const char* s, int len) {
+  int i = circuit->internName(s, len);
+  if (i == firstUse.size())
+    firstUse.push_back(line);
+  return i;
+}
+
+/** \brief Parse one INPUT, OUTPUT or gate line (starting at a name). */
+bool BenchParser::parseLine() {
+  const char* s;
+  int len;
+  int startLine = line;
+  if (!readName(s, len))
+    return fail(line, string("unexpected '") + *pos + "'");
+
+  skipSpace();
+  if ((pos < end) && (*pos == '(')) {
+    // INPUT(name) or OUTPUT(name)
+    int kw = benchKeyword(s, len);
+    if ((kw != BENCH_INPUT) && (kw != BENCH_OUTPUT))
+      return fail(startLine, "expected INPUT, OUTPUT or a gate, but found " + string(s, len));
+    pos++;
+    const char* n;
+    int nlen;
+    if (!readName(n, nlen))
+      return fail(line, "expected a signal name");
+    if (kw == BENCH_INPUT) {
+      if (!circuit->newGate(nameIndex(n, nlen), GATE_PI))
+        return fail(startLine, "signal " + string(n, nlen) + " is defined twice");
+    }
+    else
+      circuit->addOutput(nameIndex(n, nlen));
+    return expect(')');
+  }
+
+  // name = TYPE(name, name, ...)
+  if (!expect('='))
+    return false;
+  int out = nameIndex(s, len);
+  const char* t;
+  int tlen;
+  if (!readName(t, tlen))
+    return fail(line, "expected a gate type");
+  int type = benchKeyword(t, tlen);
+  if (type == BENCH_DFF)
+    return fail(line, "DFF is not supported (the circuit must be combinational)");
+  if (type < 0)
+    return fail(line, "unknown gate type " + string(t, tlen));
+  if (!expect('('))
+    return false;
+  if (!circuit->newGate(out, type))
+    return fail(startLine, "signal " + string(s, len) + " is defined twice");
+
+  int numInputs = 0;
+  while (true) {
+    const char* n;
+    int nlen;
+    if (!readName(n, nlen))
+      return fail(line, "expected a signal name");
+    circuit->addGateInput(nameIndex(n, nlen));
+    numInputs++;
+    skipSpace();
+    if ((pos < end) && (*pos == ','))
+      pos++;
+    else if (!expect(')'))
+      return false;
+    else
+      break;
+  }
+  if (((type == GATE_NOT) || (type == GATE_BUFF)) && (numInputs != 1))
+    return fail(startLine, string(t, tlen) + " gate " + string(s, len) + " must have exactly one input");
+  return true;
+}
+
+/** \brief Parse .bench text held in memory.
+ *  \param text The text (need not be '\\0'-terminated)
+ *  \param size Its length
+ *  \param name The file name to give in error messages
+ *  \return The new circuit (not set up yet, see Circuit::setupCircuit()), or NULL on an error (see getError())
+ */
+Circuit* BenchParser::parse(const char* text, size_t size, const string& name) {
+  pos = text;
+  end = text + size;
+  line = 1;
+  fileName = name;
+  error.clear();
+  firstUse.clear();
+  circuit = new Circuit;
+
+  bool ok = true;
+  for (skipSpace(); ok && (pos < end); skipSpace())
+    ok = parseLine();
+
+  // every signal used must be driven by something
+  for (int i=0; ok && (i<firstUse.size()); i++)
+    if (circuit->getNameGate(i) == SYMBOL_NOT_FOUND)
+      ok = fail(firstUse[i], "signal " + string(circuit->getName(i)) + " is used but never defined");
+
+  if (!ok) {
+    delete circuit;
+    circuit = NULL;
+  }
+  Circuit* c = circuit;
+  circuit = NULL;
+  return c;
+}
+
+/** \brief Parse a .bench file.
+ *  \param file The file name
+ *  \return The new circuit (not set up yet, see Circuit::setupCircuit()), or NULL on an error (see getError())
+ *
+ * The file is mapped into memory; if it cannot be (e.g. it is a pipe), it is read instead.
+ */
+Circuit* BenchParser::parse(const string& file) {
+  int fd = open(file.c_str(), O_RDONLY);
+  struct stat st;
+  if ((fd < 0) || (fstat(fd, &st) != 0)) {
+    if (fd >= 0)
+      close(fd);
+    error = file + ": cannot open file";
+    return NULL;
+  }
+
+  Circuit* c;
+  void* map = (st.st_size > 0) ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  if (map != MAP_FAILED) {
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    c = parse((const char*)map, st.st_size, file);
+    munmap(map, st.st_size);
+  }
+  else {
+    string text;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+      text.append(buf, n);
+    c = parse(text.data(), text.size(), file);
+  }
+  close(fd);
+  return c;
+}
@@ -0,0 +1,36 @@
+#ifndef CLASSBENCHPARSER_H
+#define CLASSBENCHPARSER_H
+
+#include "ClassCircuit.h"
+#include <string>    // string
+#include <vector>    // vector
+#include <stddef.h>  // size_t
+using namespace std;
+
+class BenchParser{
+
+ private:
+  const char* pos;             // Next character to read
+  const char* end;             // One past the last character of the file
+  int line;                    // Line number of pos (from 1)
+  Circuit* circuit;            // The circuit being built
+  vector<int> firstUse;        // Line where each signal name (by name index) was first seen
+  string fileName;             // The file being parsed, for error messages
+  string error;                // The first error found, or empty
+
+  bool fail(int errLine, const string& msg);
+  void skipSpace();
+  bool readName(const char* &s, int &len);
+  bool expect(char c);
+  int nameIndex(const char* s, int len);
+  bool parseLine();
+
+ public:
+  BenchParser();
+
+  Circuit* parse(const string& file);
+  Circuit* parse(const char* text, size_t size, const string& name);
+  const string& getError() const;
+};
+
+#endif
@@ -17,16 +17,61 @@
  * list of which gates drive the output values. So when you call \a getPOGates() you will get
  * a vector of pointers to the normal gates that drive the outputs.
  * 
+ * After \a setupCircuit(), the circuit is in a compiled (flat) form that the simulation and
+ * PODEM code run on. In this form, a gate is identified by its index, and its type, fanins and
+ * fanouts are read from contiguous arrays with \a getGateType(), \a getFanin() and \a getFanout().
+ * The Gate objects used by the functions above are only built by \a buildGates(), which gives
+ * each gate the same index (see \a getGate()); without it those functions fail an assertion.
+ * The compiled form does not store logic values; the code using it keeps its own value array
+ * indexed by gate.
+ * It also carries the SCOAP testability measures of every gate (\a getCC0(), \a getCC1(),
+ * \a getCO()), which the PODEM code uses to make its choices.
+ * 
  * Lastly, note that there are a number of functions here that are only used when the initial 
- * representation of the circuit is constructed. (This is done for you by the yyparse() function 
- * (see main.cc). These functions are ones that you will never have to manipulate yourself, and 
- * they are marked with a note that indicate this.
+ * representation of the circuit is constructed. (This is done for you by the BenchParser
+ * class.) These functions are ones that you will never have to manipulate yourself, and 
+ * they are marked with a note that indicate this. Readers refer to signals by name index
+ * (see \a internName()), so a signal can be used before the gate driving it is read, and
+ * each name is copied once however many times it is used.
  */
 
 #include "ClassCircuit.h"
+#include <fstream>     // ofstream
+#include <stdio.h>     // snprintf
+#include <string.h>    // memcmp, memcpy
+#include <fcntl.h>     // open
+#include <unistd.h>    // close
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // stat, fstat
 
 /** \brief Construct a new circuit */
-Circuit::Circuit() {}
+Circuit::Circuit() {
+  faninNameStart.push_back(0);
+  numLevels = 0;
+  pGateType = pIsOutput = NULL;
+  pFaninStart = pFanin = pFanoutStart = pFanout = pLevel = pGateName = NULL;
+  pCC0 = pCC1 = pCO = NULL;
+  mapAddr = NULL;
+  mapSize = 0;
+}
+
+/** \brief Delete the circuit's gates, and unmap its compiled file (if it was loaded from one). */
+Circuit::~Circuit() {
+  for (int i=0; i<gates.size(); i++)
+    delete gates[i];
+  if (mapAddr != NULL)
+    munmap(mapAddr, mapSize);
+}
+
+/** \brief Fail an assertion if buildGates() has not been run: the circuit has no Gate objects,
+ *  so only the compiled form (getGateType(), getFanin(), getGateName(), ...) can be used.
+ */
+void Circuit::checkHasGates() const {
+  if (gates.size() != cLevelOrder.size()) {
+    cout << "ERROR: The circuit has no Gate objects; use the compiled form, or run buildGates() first" << endl;
+    assert(false);
+  }
+}
 
 /** \brief Add a new gate to the circuit
  *  \param name a string providing the output name for the gate
@@ -35,18 +80,66 @@ Circuit::Circuit() {}
  *  \note This function should only need to be run by the parser.
  */
 void Circuit::newGate(string name, int ID, int gt) {
-    Gate* g = new Gate(name, ID, gt);
-    gates.push_back(g);
+    // gates are numbered in the order they are created
+    assert(ID == cGateType.size());
+    newGate(internName(name.data(), name.size()), gt);
+}
+
+/** \brief Get the index of a signal name, for newGate(), addGateInput() and addOutput().
+ *  \param s Pointer to the first character of the name (need not be '\\0'-terminated)
+ *  \param len Length of the name
+ *  \note This function should only need to be run by the parser.
+ */
+int Circuit::internName(const char* s, int len) {
+  return gateNames.intern(s, len);
+}
+
+/** \brief Add a new gate to the circuit. Its ID is its index.
+ *  \param name The index of the gate's output name, from internName()
+ *  \param gt the type of gate, using the GATE_* marcos defined in ClassGate.h
+ *  \return false if a gate with this output name already exists (the gate is still added)
+ *  \note This function should only need to be run by the parser.
+ */
+bool Circuit::newGate(int name, int gt) {
+    cGateType.push_back(gt);
+    cGateName.push_back(name);
+    faninNameStart.push_back(faninName.size());
 
     if (gt == GATE_PI)
-      inputGates.push_back(g);
+      cInputs.push_back(cGateType.size()-1);
+    return gateNames.define(name, cGateType.size()-1);
+}
+
+/** \brief Add an input to the gate added last.
+ *  \param name The index of the input signal's name, from internName()
+ *  \note This function should only need to be run by the parser.
+ */
+void Circuit::addGateInput(int name) {
+  faninName.push_back(name);
+  faninNameStart.back()++;
+}
+
+/** \brief Record a primary output of this circuit.
+ *  \param name The index of the output signal's name, from internName()
+ *  \note This function should only need to be run by the parser.
+ */
+void Circuit::addOutput(int name) {
+  outputNames.push_back(name);
 }
 
+/** \brief Get a signal name from its index (see internName()). */
+const char* Circuit::getName(int name) const { return gateNames.getName(name); }
+
+/** \brief Get the gate driving signal \a name (see internName()): its index, or SYMBOL_NOT_FOUND
+ *  if no gate has been added with that output name, or SYMBOL_AMBIGUOUS if several have. */
+int Circuit::getNameGate(int name) const { return gateNames.getValue(name); }
+
 /** \brief Get pointer to gate \a i from the circuit
  *  \param i gate number
  *  \return Pointer to Gate \a i
  */
 Gate* Circuit::getGate(int i) {
+  checkHasGates();
   if (i >= gates.size()) {
     cout << "ERROR: Requested gate out of bounds" << endl;
     assert(false);
@@ -59,12 +152,13 @@ Gate* Circuit::getGate(int i) {
  *  \note This function should only need to be run by the parser.
  */
 void Circuit::addOutputName(string n) {
-  outputNames.push_back(n);
+  addOutput(internName(n.data(), n.size()));
 }
 
 /** \brief Print the circuit
  */
 void Circuit::printAllGates() {
+  checkHasGates();
   cout << "Inputs: ";
   for (int i=0; i<inputGates.size(); i++)
     cout << inputGates[i]->get_outputName() << " ";
@@ -85,28 +179,46 @@ void Circuit::printAllGates() {
  *  \param name A string containing the name of the gate requested
  *  \return Pointer to the Gate with output given by \a name
  *  Will fail an assertion if multiple gates with that name are found, or if none are.
- *  \note This function should probably only need to be called by the parser.
  */
 Gate* Circuit::findGateByName(string name) {
-	Gate* res;
-	bool found = false;
-
-	for (int i=0; i<gates.size(); i++) {
-		if (gates[i]->get_outputName().compare(name) == 0) {
-			res = gates[i];
-			assert(!found);
-			found = true;
-		}
-  	}
-  
-  if (!found)
+  checkHasGates();
+  int i = gateNames.find(name);
+
+  if (i == SYMBOL_NOT_FOUND)
   	cout << "ERROR: Cannot find: " << name << endl;
+  else if (i == SYMBOL_AMBIGUOUS)
+  	cout << "ERROR: Multiple gates named: " << name << endl;
   	
-  assert(found);
-  return res;
+  assert(i >= 0);
+  return gates[i];
   
 }
 
+/** \brief Returns the index of the gate driving the signal with name index \a name (see internName()).
+ *  Fails an assertion, like findGateByName(), if there is no such gate or there are several.
+ */
+int Circuit::findGateByNameIndex(int name) {
+  int i = gateNames.getValue(name);
+
+  if (i == SYMBOL_NOT_FOUND)
+  	cout << "ERROR: Cannot find: " << gateNames.getName(name) << endl;
+  else if (i == SYMBOL_AMBIGUOUS)
+  	cout << "ERROR: Multiple gates named: " << gateNames.getName(name) << endl;
+
+  assert(i >= 0);
+  return i;
+}
+
+/** \brief Returns the index of the gate in this circuit with output name \a name.
+ *  \param name A string containing the name of the gate requested
+ *  \return The gate's index (as used by getGate() and the compiled form), or SYMBOL_NOT_FOUND
+ *  if there is no such gate, or SYMBOL_AMBIGUOUS if several gates have this name.
+ *  \note Use this in readers (e.g. of fault or pattern files) that want to report a bad name themselves.
+ */
+int Circuit::findGateIndexByName(const string& name) {
+  return gateNames.find(name);
+}
+
 /** \brief Sets up the circuit data structures after parsing is complete.
  *  Run this once after parsing, before using the data structure.
  *  The handout \a main.cc code already does this; you do not need to add it yourself.
@@ -114,22 +226,19 @@ Gate* Circuit::findGateByName(string name) {
 void Circuit::setupCircuit() {
 
   // set-up the vector of output gates based on their pre-stored names
-  for (int i=0; i<outputNames.size(); i++) {
-    outputGates.push_back(findGateByName(outputNames[i]));
-  }
+  for (int i=0; i<outputNames.size(); i++)
+    cOutputs.push_back(findGateByNameIndex(outputNames[i]));
+  vector<int>().swap(outputNames);
 
-  // set input and output pointers of each gate
-  for (int i=0; i<gates.size(); i++) {
-    Gate* g = gates[i];
-    vector<string> names = g->get_gateInputNames();
-    for (int j=0; j<names.size(); j++) {
-      string n = names[j];
-      Gate* inGate = findGateByName(n);
-      inGate->set_gateOutput(g);
-      g->set_gateInput(inGate);
-    }
+  // resolve the fanin names to gate indices: the fanins are now in CSR form
+  int n = cGateType.size();
+  cFaninStart.swap(faninNameStart);
+  cFanin.swap(faninName);
+  vector<uint32_t> numFanouts(n, 0);
+  for (int e=0; e<cFanin.size(); e++) {
+    cFanin[e] = findGateByNameIndex(cFanin[e]);
+    numFanouts[cFanin[e]]++;
   }
-  
 
   // In order for the fault simulator to consider fanout stems and
   // branches as different faults, here we find all the gates that have
@@ -150,48 +259,174 @@ void Circuit::setupCircuit() {
   //
   // Given this new type of gate, now any possible single-stuck-at gate fault site
   // is a gate output.
-  for (int i=0; i<gates.size(); i++) {
-  	Gate* g = gates[i];
-  	vector<Gate*> go = g->get_gateOutputs();
-  	
-  	if ((g->get_gateType() != GATE_FANOUT) && (go.size() > 1)) {  		
-  		for (int j=0; j<go.size(); j++) {	
-  		
-  			// Before running: 
-  			//    g --> go[j]
-  			// After:
-  			//    g --> newG --> go[j], where newG is a gate of type FANOUT
-  		
-  			ostringstream ss;
-  			ss << g->get_outputName() << "_" << (int)j;
-			newGate(ss.str(), gates.size(), GATE_FANOUT);  		
-			Gate* newFanoutGate = gates.back();
-			
-			// change g's output[j] to point to newFanoutGate
-			g->replace_gateOutput(go[j], newFanoutGate);
-			
-			// set newFanoutGate's input to point to g
-			newFanoutGate->set_gateInput(g);
-			
-			// change go[j]'s appropriate input to point to newFanoutGate
-			go[j]->replace_gateInput(g, newFanoutGate);
-			
-			// set newFanoutGate's output to point to go[j]
-			newFanoutGate->set_gateOutput(go[j]);
-			
-			
-		}
-  	}
+  //
+  // Branch j of a stem feeds the stem's j-th use, counting fanin slots in gate order. The
+  // branches of each stem get consecutive indices; nextBranch[i] is the next one to hand out.
+  vector<uint32_t> nextBranch(n, 0);
+  string branchName;
+  char suffix[16];
+  for (int i=0; i<n; i++) {
+    if ((cGateType[i] == GATE_FANOUT) || (numFanouts[i] <= 1))
+      continue;
+    nextBranch[i] = cGateType.size();
+    branchName = gateNames.getName(cGateName[i]);
+    for (int j=0; j<numFanouts[i]; j++) {
+      int len = snprintf(suffix, sizeof(suffix), "_%d", j);
+      branchName.append(suffix, len);
+      newGate(internName(branchName.data(), branchName.size()), GATE_FANOUT);
+      branchName.resize(branchName.size() - len);
+      cFanin.push_back(i);
+      cFaninStart.push_back(cFanin.size());
+    }
   }
-  
-  checkPointerConsistency();
 
+  // point each use of a stem at its own branch
+  for (int e=0; e<cFaninStart[n]; e++) {
+    if (nextBranch[cFanin[e]] != 0)
+      cFanin[e] = nextBranch[cFanin[e]]++;
+  }
+  vector<uint32_t>().swap(faninNameStart);
+  vector<uint32_t>().swap(faninName);
+
+  compileCircuit();
+
+  checkConsistency();
+}
+
+/** \brief Builds the rest of the compiled form of the circuit from its fanin lists.
+ *  The fanout lists are packed into index arrays (CSR form) like the fanins, with 32-bit start
+ *  offsets per gate; a gate's fanouts are listed in gate order.
+ *  \note This is run at the end of setupCircuit(); the compiled form does not change after that.
+ */
+void Circuit::compileCircuit() {
+  int n = cGateType.size();
+
+  // count the fanouts of each gate, then place them
+  cFanoutStart.assign(n+1, 0);
+  for (int e=0; e<cFanin.size(); e++)
+    cFanoutStart[cFanin[e]+1]++;
+  for (int i=0; i<n; i++)
+    cFanoutStart[i+1] += cFanoutStart[i];
+  cFanout.resize(cFanin.size());
+  vector<uint32_t> next(cFanoutStart.begin(), cFanoutStart.end()-1);
+  for (int i=0; i<n; i++) {
+    for (uint32_t e=cFaninStart[i]; e<cFaninStart[i+1]; e++)
+      cFanout[next[cFanin[e]]++] = i;
+  }
+
+  cIsOutput.assign(n, 0);
+  for (int i=0; i<cOutputs.size(); i++)
+    cIsOutput[cOutputs[i]] = 1;
+
+  bindCompiled();
+  computeLevels();
+  computeSCOAP();
+  bindCompiled();
+}
+
+/** \brief Creates the Gate objects from the compiled form, for code that uses the Gate API
+ *  (getGate(), getPIGates(), setPIValues(), ...), like the handout simulator in main.cc.
+ *  Gate \a i of the compiled form is getGate(i), with the same name, type, inputs and outputs.
+ *  Run this after setupCircuit() or loadCompiled(); it does nothing if the gates exist already.
+ *  \note The Gate objects take several times the memory of the compiled form, and the PODEM
+ *  code does not use them, so they are only built on request.
+ */
+void Circuit::buildGates() {
+  if (!gates.empty())
+    return;
+  int n = cLevelOrder.size();
+  gates.resize(n);
+  for (int i=0; i<n; i++)
+    gates[i] = new Gate(getGateName(i), i, getGateType(i));
+  for (int i=0; i<n; i++) {
+    for (int j=0; j<getFaninCount(i); j++)
+      gates[i]->set_gateInput(gates[getFanin(i)[j]]);
+    for (int j=0; j<getFanoutCount(i); j++)
+      gates[i]->set_gateOutput(gates[getFanout(i)[j]]);
+  }
+  for (int i=0; i<cInputs.size(); i++)
+    inputGates.push_back(gates[cInputs[i]]);
+  for (int i=0; i<cOutputs.size(); i++)
+    outputGates.push_back(gates[cOutputs[i]]);
+}
+
+/** \brief Point the accessors at the compiled arrays held in this object's vectors. */
+void Circuit::bindCompiled() {
+  pGateType = cGateType.data();
+  pFaninStart = cFaninStart.data();
+  pFanin = cFanin.data();
+  pFanoutStart = cFanoutStart.data();
+  pFanout = cFanout.data();
+  pIsOutput = cIsOutput.data();
+  pLevel = cLevel.data();
+  pCC0 = cCC0.data();
+  pCC1 = cCC1.data();
+  pCO = cCO.data();
+  pGateName = cGateName.data();
+}
+
+/** \brief Get the output name of gate \a g (valid after setupCircuit() or loadCompiled()). */
+const char* Circuit::getGateName(int g) const { return gateNames.getName(pGateName[g]); }
+
+/** \brief Levelizes the compiled circuit.
+ *  The level of a PI is 0, and the level of any other gate is one more than the highest level
+ *  of its fanins, so every gate's fanouts are at a strictly higher level than the gate itself.
+ *  Also builds the list of all gates sorted by level, which is a valid order for simulating the
+ *  whole circuit in one pass.
+ *  \note This is run by compileCircuit(). It will fail an assertion if the circuit has a cycle.
+ */
+void Circuit::computeLevels() {
+  int n = cGateType.size();
+
+  // Kahn's algorithm: a gate is ready once all of its fanins have been levelized.
+  vector<uint32_t> pending(n);
+  cLevel.assign(n, 0);
+  cLevelOrder.clear();
+  cLevelOrder.reserve(n);
+  for (int i=0; i<n; i++) {
+    pending[i] = getFaninCount(i);
+    if (pending[i] == 0)
+      cLevelOrder.push_back(i);
+  }
+
+  for (int k=0; k<cLevelOrder.size(); k++) {
+    int g = cLevelOrder[k];
+    const uint32_t* fo = getFanout(g);
+    for (int j=0; j<getFanoutCount(g); j++) {
+      cLevel[fo[j]] = max(cLevel[fo[j]], cLevel[g] + 1);
+      if (--pending[fo[j]] == 0)
+        cLevelOrder.push_back(fo[j]);
+    }
+  }
+
+  if (cLevelOrder.size() != n)
+    cout << "ERROR: Circuit is not combinational (found a cycle)" << endl;
+  assert(cLevelOrder.size() == n);
+
+  // Kahn's order is topological but not sorted by level; sort it (stable, so ties keep that order).
+  numLevels = 0;
+  for (int i=0; i<n; i++)
+    numLevels = max(numLevels, (int)cLevel[i] + 1);
+
+  vector<uint32_t> levelStart(numLevels+1, 0);
+  for (int i=0; i<n; i++)
+    levelStart[cLevel[i]+1]++;
+  for (int l=0; l<numLevels; l++)
+    levelStart[l+1] += levelStart[l];
+
+  vector<uint32_t> sorted(n);
+  for (int k=0; k<n; k++) {
+    int g = cLevelOrder[k];
+    sorted[levelStart[cLevel[g]]++] = g;
+  }
+  cLevelOrder.swap(sorted);
 }
 
 /** \brief Initializes the values of the PIs of the circuit.
  *  \param inputVals the desired input values (using LOGIC_* macros).
  */
 void Circuit::setPIValues(vector<char> inputVals) {
+  checkHasGates();
   if (inputVals.size() != inputGates.size()) {
     cout << "ERROR: Incorrect number of input values: " << inputVals.size() << " vs " << inputGates.size() << endl;
     assert(false);
@@ -216,6 +451,7 @@ void Circuit::setPIValues(vector<char> inputVals) {
 /** \brief Returns the output values on each PO of this circuit.
  */
 vector<int> Circuit::getPOValues() { 
+  checkHasGates();
   vector<int> outVals;
   for (int i=0; i < outputGates.size(); i++) 
     outVals.push_back(outputGates[i]->getValue());
@@ -225,19 +461,22 @@ vector<int> Circuit::getPOValues() {
 
 /** \brief Get the number of PIs of the circuit.
  *  \return The number of PIs of the circuit. */
-int Circuit::getNumberPIs() { return inputGates.size(); }
+int Circuit::getNumberPIs() { return cInputs.size(); }
 
 /** \brief Get the number of POs of the circuit.
  *  \return The number of POs of the circuit. */
-int Circuit::getNumberPOs() { return outputGates.size(); }
+int Circuit::getNumberPOs() { return cOutputs.size(); }
 
 /** \brief Get the number of gates of the circuit.
  *  \return The number of gates of the circuit.
  */
-int Circuit::getNumberGates() { return gates.size(); }
+int Circuit::getNumberGates() {
+  return cLevelOrder.size();
+}
 
 /** \brief Clears the value of each gate in the circuit (to LOGIC_UNSET) */
 void Circuit::clearGateValues() {
+  checkHasGates();
   for (int i=0; i<gates.size(); i++) {
     gates[i]->setValue(LOGIC_UNSET);
   }
@@ -246,44 +485,35 @@ void Circuit::clearGateValues() {
 
 /** \brief Returns the PI (input) gates. (The PIs of the circuit).
     \return a \a vector<Gate*> of the circuit's PIs */
-vector<Gate*> Circuit::getPIGates() { return inputGates; }
+vector<Gate*> Circuit::getPIGates() {
+  checkHasGates();
+  return inputGates;
+}
 
 /** \brief Returns the PO (output) gates. (The gates which drive the POs of the circuit.)
     \return a \a vector<Gate*> of the circuit's POs */
-vector<Gate*> Circuit::getPOGates() { return outputGates; }
+vector<Gate*> Circuit::getPOGates() {
+  checkHasGates();
+  return outputGates;
+}
 
-/** \brief Private function for Circuit to check input and output pointers
- *   for all gates are set consistently. Just used in setting up circuit.
+/** \brief Private function for Circuit to check that the compiled form is set up consistently.
+ *   Just used in setting up circuit.
  */ 
-void Circuit::checkPointerConsistency() {
-  
-  for (int i=0; i<gates.size(); i++) {
-    Gate* g = gates[i];
-    
-    // every gate in g's input list must have g in its output list
-    vector<Gate*> gi = g->get_gateInputs();
-    for (int j=0; j < gi.size(); j++) {
-      vector<Gate*> gi_go = gi[j]->get_gateOutputs();
-      assert(find(gi_go.begin(), gi_go.end(), g) != gi_go.end());
-    }
-    
-    // every gate in g's output list must have g in its input list
-    vector<Gate*> go = g->get_gateOutputs();
-    for (int j=0; j < go.size(); j++) {
-      vector<Gate*> go_gi = go[j]->get_gateInputs();
-      assert(find(go_gi.begin(), go_gi.end(), g) != go_gi.end());
-    }	
-  }	
-  
-  // check that fanout goes to FANOUT gates only
-  for (int i=0; i<gates.size(); i++) {
-    Gate* g = gates[i];
-    vector<Gate*> go = g->get_gateOutputs();
-    
-    if (go.size() > 1) {
-      for (int j=0; j<go.size(); j++) {
-	assert(go[j]->get_gateType() == GATE_FANOUT);
-      }
+void Circuit::checkConsistency() {
+  int n = cGateType.size();
+  assert((cFaninStart.size() == n+1) && (cFanoutStart.size() == n+1));
+  assert((cFaninStart[n] == cFanin.size()) && (cFanoutStart[n] == cFanout.size()));
+
+  // every fanin edge appears once as a fanout edge
+  assert(cFanin.size() == cFanout.size());
+  for (int i=0; i<n; i++) {
+    const uint32_t* fo = getFanout(i);
+    for (int j=0; j<getFanoutCount(i); j++) {
+      assert((j == 0) || (fo[j-1] <= fo[j]));
+      // fanout goes to FANOUT gates only, and a FANOUT gate has one input
+      if (getFanoutCount(i) > 1)
+        assert((getGateType(fo[j]) == GATE_FANOUT) && (getFaninCount(fo[j]) == 1) && (getFanin(fo[j])[0] == i));
     }
   }
 }
@@ -292,7 +522,346 @@ void Circuit::checkPointerConsistency() {
  *  \note We run this function as part of the setup code; you should not need to run this.
 */
 void Circuit::clearFaults() {
+  checkHasGates();
   for (int i=0; i<gates.size(); i++) {
     gates[i]->set_faultType(NOFAULT);
   }
 }
+
+/** \brief Adds two SCOAP measures, saturating at SCOAP_INF. */
+static int scoapAdd(int a, int b) {
+  return (a >= SCOAP_INF - b) ? SCOAP_INF : a + b;
+}
+
+/** \brief Computes the SCOAP testability measures of the compiled circuit.
+ *  CC0 and CC1 (the effort to set a gate's output to 0 or 1) are computed in level order
+ *  from the PIs, which have CC0 = CC1 = 1. CO (the effort to observe a gate's output at a PO)
+ *  is then computed in reverse level order from the POs, which have CO = 0.
+ *  FANOUT gates are not real gates, so they add nothing: a branch has the controllability of
+ *  its stem, and a stem has the best observability of its branches.
+ *  \note This is run by compileCircuit().
+ */
+void Circuit::computeSCOAP() {
+  int n = cLevelOrder.size();
+  cCC0.assign(n, SCOAP_INF);
+  cCC1.assign(n, SCOAP_INF);
+  cCO.assign(n, SCOAP_INF);
+
+  for (int k=0; k<n; k++) {
+    int g = cLevelOrder[k];
+    const uint32_t* in = getFanin(g);
+    int numIn = getFaninCount(g);
+    char t = getGateType(g);
+
+    if (t == GATE_PI) {
+      cCC0[g] = 1;
+      cCC1[g] = 1;
+    }
+    else if ((t == GATE_BUFF) || (t == GATE_NOT) || (t == GATE_FANOUT)) {
+      int cost = (t == GATE_FANOUT) ? 0 : 1;
+      int c0 = (t == GATE_NOT) ? cCC1[in[0]] : cCC0[in[0]];
+      int c1 = (t == GATE_NOT) ? cCC0[in[0]] : cCC1[in[0]];
+      cCC0[g] = scoapAdd(c0, cost);
+      cCC1[g] = scoapAdd(c1, cost);
+    }
+    else if ((t == GATE_AND) || (t == GATE_NAND) || (t == GATE_OR) || (t == GATE_NOR)) {
+      // ctrl: output (before inversion) when any input is controlling; all: when all are non-controlling
+      const vector<int>& ccCtrl = ((t == GATE_AND) || (t == GATE_NAND)) ? cCC0 : cCC1;
+      const vector<int>& ccNonCtrl = ((t == GATE_AND) || (t == GATE_NAND)) ? cCC1 : cCC0;
+      int ctrl = SCOAP_INF, all = 0;
+      for (int j=0; j<numIn; j++) {
+        ctrl = min(ctrl, ccCtrl[in[j]]);
+        all = scoapAdd(all, ccNonCtrl[in[j]]);
+      }
+      ctrl = scoapAdd(ctrl, 1);
+      all = scoapAdd(all, 1);
+      // AND: 0 is the controlled output; NAND inverts it; OR: 1 is the controlled output; NOR inverts it.
+      bool ctrlIsZero = (t == GATE_AND) || (t == GATE_NOR);
+      cCC0[g] = ctrlIsZero ? ctrl : all;
+      cCC1[g] = ctrlIsZero ? all : ctrl;
+    }
+    else if ((t == GATE_XOR) || (t == GATE_XNOR)) {
+      // fold the inputs pairwise: c0/c1 are the costs of an even/odd number of ones so far
+      int c0 = cCC0[in[0]], c1 = cCC1[in[0]];
+      for (int j=1; j<numIn; j++) {
+        int n0 = min(scoapAdd(c0, cCC0[in[j]]), scoapAdd(c1, cCC1[in[j]]));
+        int n1 = min(scoapAdd(c0, cCC1[in[j]]), scoapAdd(c1, cCC0[in[j]]));
+        c0 = n0;
+        c1 = n1;
+      }
+      cCC0[g] = scoapAdd((t == GATE_XOR) ? c0 : c1, 1);
+      cCC1[g] = scoapAdd((t == GATE_XOR) ? c1 : c0, 1);
+    }
+  }
+
+  for (int i=0; i<cOutputs.size(); i++)
+    cCO[cOutputs[i]] = 0;
+
+  for (int k=n-1; k>=0; k--) {
+    int g = cLevelOrder[k];
+    const uint32_t* in = getFanin(g);
+    int numIn = getFaninCount(g);
+    char t = getGateType(g);
+    if (cCO[g] == SCOAP_INF)
+      continue;
+    
+    for (int j=0; j<numIn; j++) {
+      // cost of setting all the other inputs so that input j is observable at this gate's output
+      int side = 0;
+      for (int k2=0; k2<numIn; k2++) {
+        if (k2 == j)
+          continue;
+        if ((t == GATE_AND) || (t == GATE_NAND))
+          side = scoapAdd(side, cCC1[in[k2]]);
+        else if ((t == GATE_OR) || (t == GATE_NOR))
+          side = scoapAdd(side, cCC0[in[k2]]);
+        else
+          side = scoapAdd(side, min(cCC0[in[k2]], cCC1[in[k2]]));
+      }
+      int co = scoapAdd(scoapAdd(cCO[g], side), (t == GATE_FANOUT) ? 0 : 1);
+      cCO[in[j]] = min(cCO[in[j]], co);
+    }
+  }
+}
+
+// Compiled circuit files (see saveCompiled())
+#define COMPILED_MAGIC      "ATPGNET"   // the first 8 bytes, with the '\0'
+#define COMPILED_BYTE_ORDER 0x01020304  // written as a native integer, so a file from a machine with another byte order is refused
+#define COMPILED_HAS_SCOAP  1           // flag: the file has the SCOAP sections
+
+/** @brief The start of a compiled circuit file. The sections follow it (see saveCompiled()). */
+struct CompiledHeader {
+  char magic[8];
+  uint32_t version;     // COMPILED_VERSION
+  uint32_t byteOrder;   // COMPILED_BYTE_ORDER
+  uint32_t flags;       // COMPILED_HAS_SCOAP, or 0
+  uint32_t numGates;
+  uint32_t numEdges;    // fanin (and fanout) connections
+  uint32_t numPIs;
+  uint32_t numPOs;
+  uint32_t numLevels;
+  uint32_t numNames;    // names in the name table
+  uint32_t numSlots;    // size of the name table's hash table
+  uint32_t poolSize;    // bytes of names
+  uint32_t unused;
+  uint64_t sourceSize;  // size and modification time of the file the circuit was read from (0 if unknown)
+  int64_t sourceTime;
+  uint64_t fileSize;    // size of the whole file
+  uint64_t checksum;    // over the sections, then the header with this field 0
+};
+
+// The sections of a compiled circuit file, in file order
+enum { SEC_GATE_TYPE, SEC_IS_OUTPUT, SEC_FANIN_START, SEC_FANIN, SEC_FANOUT_START, SEC_FANOUT, SEC_INPUTS,
+       SEC_OUTPUTS, SEC_LEVEL, SEC_LEVEL_ORDER, SEC_GATE_NAME, SEC_NAME_START, SEC_NAME_LENGTH, SEC_NAME_HASH,
+       SEC_NAME_VALUE, SEC_SLOTS, SEC_POOL, SEC_CC0, SEC_CC1, SEC_CO, COMPILED_SECTIONS };
+
+/** \brief Round a section size up to a multiple of 8 bytes, so every section is aligned. */
+static size_t compiledPad(size_t n) { return (n + 7) & ~(size_t)7; }
+
+/** \brief Get the size in bytes of each section described by header \a h.
+ *  \return The size of the whole file
+ */
+static size_t compiledSections(const CompiledHeader& h, size_t* sizes) {
+  size_t n = h.numGates, w = sizeof(uint32_t);
+  sizes[SEC_GATE_TYPE] = n;
+  sizes[SEC_IS_OUTPUT] = n;
+  sizes[SEC_FANIN_START] = sizes[SEC_FANOUT_START] = (n + 1) * w;
+  sizes[SEC_FANIN] = sizes[SEC_FANOUT] = (size_t)h.numEdges * w;
+  sizes[SEC_INPUTS] = (size_t)h.numPIs * w;
+  sizes[SEC_OUTPUTS] = (size_t)h.numPOs * w;
+  sizes[SEC_LEVEL] = sizes[SEC_LEVEL_ORDER] = sizes[SEC_GATE_NAME] = n * w;
+  sizes[SEC_NAME_START] = sizes[SEC_NAME_LENGTH] = sizes[SEC_NAME_HASH] = sizes[SEC_NAME_VALUE] = (size_t)h.numNames * w;
+  sizes[SEC_SLOTS] = (size_t)h.numSlots * w;
+  sizes[SEC_POOL] = h.poolSize;
+  sizes[SEC_CC0] = sizes[SEC_CC1] = sizes[SEC_CO] = (h.flags & COMPILED_HAS_SCOAP) ? n * w : 0;
+
+  size_t total = sizeof(CompiledHeader);
+  for (int i=0; i<COMPILED_SECTIONS; i++)
+    total += compiledPad(sizes[i]);
+  return total;
+}
+
+/** \brief Fold \a n bytes (a multiple of 8) into a running checksum. */
+static uint64_t compiledChecksum(uint64_t h, const char* p, size_t n) {
+  for (size_t i=0; i<n; i+=8) {
+    uint64_t w;
+    memcpy(&w, p+i, 8);
+    h = ((h << 5) | (h >> 59)) ^ w;
+    h *= 0x9E3779B97F4A7C15ULL;
+  }
+  return h;
+}
+
+/** \brief Save the compiled form of the circuit, so later runs can load it instead of parsing.
+ *  \param file The file to write
+ *  \param source The file the circuit was read from (its size and time are recorded, see loadCompiled()), or empty
+ *  \param withSCOAP If true, the SCOAP measures are saved too; otherwise loadCompiled() recomputes them
+ *  \return false if the file cannot be written
+ *
+ * The file is a header followed by the compiled arrays (types, CSR fanin and fanout, PIs, POs,
+ * levels, level order, the name table with its hash table, and SCOAP), each one as it is in
+ * memory and padded to 8 bytes, so a mapped file can be used in place. Run after setupCircuit().
+ */
+bool Circuit::saveCompiled(const string& file, const string& source, bool withSCOAP) const {
+  const SymbolTableData& names = gateNames.getData();
+  int n = cLevelOrder.size();
+
+  CompiledHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, COMPILED_MAGIC, sizeof(h.magic));
+  h.version = COMPILED_VERSION;
+  h.byteOrder = COMPILED_BYTE_ORDER;
+  h.flags = withSCOAP ? COMPILED_HAS_SCOAP : 0;
+  h.numGates = n;
+  h.numEdges = pFaninStart[n];
+  h.numPIs = cInputs.size();
+  h.numPOs = cOutputs.size();
+  h.numLevels = numLevels;
+  h.numNames = names.numNames;
+  h.numSlots = names.numSlots;
+  h.poolSize = names.poolSize;
+  struct stat st;
+  if (!source.empty() && (stat(source.c_str(), &st) == 0)) {
+    h.sourceSize = st.st_size;
+    h.sourceTime = st.st_mtime;
+  }
+
+  size_t sizes[COMPILED_SECTIONS];
+  h.fileSize = compiledSections(h, sizes);
+  const void* data[COMPILED_SECTIONS] = { pGateType, pIsOutput, pFaninStart, pFanin, pFanoutStart, pFanout,
+    cInputs.data(), cOutputs.data(), pLevel, cLevelOrder.data(), pGateName, names.nameStart, names.nameLength,
+    names.nameHash, names.nameValue, names.slots, names.pool, pCC0, pCC1, pCO };
+
+  ofstream out(file.c_str(), ios::binary);
+  if (!out.is_open())
+    return false;
+  out.write((const char*)&h, sizeof(h));
+  uint64_t sum = 0;
+  for (int i=0; i<COMPILED_SECTIONS; i++) {
+    const char* p = (const char*)data[i];
+    size_t full = sizes[i] & ~(size_t)7;
+    out.write(p, full);
+    sum = compiledChecksum(sum, p, full);
+    if (sizes[i] > full) {
+      char last[8] = { 0 };
+      memcpy(last, p + full, sizes[i] - full);
+      out.write(last, 8);
+      sum = compiledChecksum(sum, last, 8);
+    }
+  }
+  h.checksum = compiledChecksum(sum, (const char*)&h, sizeof(h));
+  out.seekp(0);
+  out.write((const char*)&h, sizeof(h));
+  return out.good();
+}
+
+/** \brief Load a circuit saved with saveCompiled(), instead of parsing and setting it up.
+ *  \param file The compiled file
+ *  \param source The file it should have been compiled from (or empty). If that file exists and
+ *  its size or time differs from when the circuit was saved, the compiled file is out of date.
+ *  \param error Output: what is wrong, if this returns false
+ *  \return false if the file cannot be read, is not a compiled circuit, was written by another
+ *  version of the format, fails its checksum, or is out of date
+ *
+ * The file is mapped into memory and the compiled arrays and name table are used where they are,
+ * with no per-gate allocation; only the PI, PO and level-order lists are copied. A loaded circuit
+ * has no Gate objects, like one set up by setupCircuit(): use the compiled form (getGateType(),
+ * getFanin(), getGateName(), ...), or run buildGates().
+ * Call this on a new Circuit, in place of setupCircuit().
+ */
+bool Circuit::loadCompiled(const string& file, const string& source, string& error) {
+  assert(cGateType.empty() && (mapAddr == NULL));
+
+  int fd = open(file.c_str(), O_RDONLY);
+  struct stat st;
+  if ((fd < 0) || (fstat(fd, &st) != 0)) {
+    if (fd >= 0)
+      close(fd);
+    error = file + ": cannot open file";
+    return false;
+  }
+  if (st.st_size < sizeof(CompiledHeader)) {
+    close(fd);
+    error = file + ": not a compiled circuit";
+    return false;
+  }
+  size_t length = st.st_size;
+  void* map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    error = file + ": cannot map file";
+    return false;
+  }
+
+  // check the header, the size and the checksum
+  const char* base = (const char*)map;
+  CompiledHeader h;
+  memcpy(&h, base, sizeof(h));
+  size_t sizes[COMPILED_SECTIONS];
+  ostringstream problem;
+  if (memcmp(h.magic, COMPILED_MAGIC, sizeof(h.magic)) != 0)
+    problem << "not a compiled circuit";
+  else if (h.byteOrder != COMPILED_BYTE_ORDER)
+    problem << "written on a machine with a different byte order";
+  else if (h.version != COMPILED_VERSION)
+    problem << "format version " << h.version << ", but this program reads version " << COMPILED_VERSION;
+  else if ((h.fileSize != length) || (compiledSections(h, sizes) != h.fileSize))
+    problem << "truncated or corrupt";
+  else {
+    uint64_t sum = compiledChecksum(0, base + sizeof(h), h.fileSize - sizeof(h));
+    uint64_t expected = h.checksum;
+    struct stat sourceSt;
+    h.checksum = 0;
+    if (compiledChecksum(sum, (const char*)&h, sizeof(h)) != expected)
+      problem << "checksum mismatch (corrupt file)";
+    else if (!source.empty() && (stat(source.c_str(), &sourceSt) == 0) &&
+             ((sourceSt.st_size != h.sourceSize) || (sourceSt.st_mtime != h.sourceTime)))
+      problem << "out of date (" << source << " has changed since it was compiled)";
+  }
+  if (!problem.str().empty()) {
+    munmap(map, length);
+    error = file + ": " + problem.str();
+    return false;
+  }
+
+  const char* sec[COMPILED_SECTIONS];
+  const char* p = base + sizeof(h);
+  for (int i=0; i<COMPILED_SECTIONS; i++) {
+    sec[i] = p;
+    p += compiledPad(sizes[i]);
+  }
+
+  pGateType = sec[SEC_GATE_TYPE];
+  pIsOutput = sec[SEC_IS_OUTPUT];
+  pFaninStart = (const uint32_t*)sec[SEC_FANIN_START];
+  pFanin = (const uint32_t*)sec[SEC_FANIN];
+  pFanoutStart = (const uint32_t*)sec[SEC_FANOUT_START];
+  pFanout = (const uint32_t*)sec[SEC_FANOUT];
+  pLevel = (const uint32_t*)sec[SEC_LEVEL];
+  pGateName = (const uint32_t*)sec[SEC_GATE_NAME];
+  cInputs.assign((const uint32_t*)sec[SEC_INPUTS], (const uint32_t*)sec[SEC_INPUTS] + h.numPIs);
+  cOutputs.assign((const uint32_t*)sec[SEC_OUTPUTS], (const uint32_t*)sec[SEC_OUTPUTS] + h.numPOs);
+  cLevelOrder.assign((const uint32_t*)sec[SEC_LEVEL_ORDER], (const uint32_t*)sec[SEC_LEVEL_ORDER] + h.numGates);
+  numLevels = h.numLevels;
+
+  SymbolTableData names = { sec[SEC_POOL], h.poolSize, (const uint32_t*)sec[SEC_NAME_START],
+    (const uint32_t*)sec[SEC_NAME_LENGTH], (const uint32_t*)sec[SEC_NAME_HASH], (const int*)sec[SEC_NAME_VALUE],
+    h.numNames, (const uint32_t*)sec[SEC_SLOTS], h.numSlots };
+  gateNames.attach(names);
+
+  if (h.flags & COMPILED_HAS_SCOAP) {
+    pCC0 = (const int*)sec[SEC_CC0];
+    pCC1 = (const int*)sec[SEC_CC1];
+    pCO = (const int*)sec[SEC_CO];
+  }
+  else {
+    computeSCOAP();
+    pCC0 = cCC0.data();
+    pCC1 = cCC1.data();
+    pCO = cCO.data();
+  }
+
+  mapAddr = map;
+  mapSize = length;
+  return true;
+}
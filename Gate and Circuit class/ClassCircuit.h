@@ -2,28 +2,90 @@
 #define CLASSCIRCUIT_H
 
 #include "ClassGate.h"
+#include "ClassSymbolTable.h"
 #include <assert.h>  // assert
 #include <iostream>  // cout
 #include <vector>    // vector
 #include <sstream>
+#include <string>    // string
+#include <stdint.h>  // uint32_t
+#include <stddef.h>  // size_t
+
+// SCOAP measures are capped at this value (e.g. for signals that cannot be observed)
+#define SCOAP_INF 1000000000
+
+// Version of the compiled circuit file format (see Circuit::saveCompiled()); bump it when the format changes
+#define COMPILED_VERSION 1
 
 class Circuit{
  private:
-  vector<Gate*> gates;            // Pointers to all gates in the circuit
-  vector<Gate*> outputGates;      // Pointers to all gates driving POs
-  vector<Gate*> inputGates;       // Pointers to all PIs
-  vector<string> outputNames;     // A vector with output names (only used in setup)
-  void checkPointerConsistency(); // An internal function to check that the Circuit is setup correctly.
+  vector<Gate*> gates;            // Pointers to all gates in the circuit (only after buildGates())
+  vector<Gate*> outputGates;      // Pointers to all gates driving POs (only after buildGates())
+  vector<Gate*> inputGates;       // Pointers to all PIs (only after buildGates())
+  vector<int> outputNames;        // Name index (in gateNames) of each output (only used in setup)
+  vector<uint32_t> faninNameStart; // Fanin names of gate i are faninName[faninNameStart[i]] .. faninName[faninNameStart[i+1]-1] (only used in setup)
+  vector<uint32_t> faninName;     // Concatenated fanin name indices of all gates (only used in setup)
+  SymbolTable gateNames;          // Maps each gate's output name to its index in gates
+  void checkConsistency();        // An internal function to check that the Circuit is setup correctly.
+  int findGateByNameIndex(int name);
+
+  // Compiled (flat) form of the circuit, built by setupCircuit() and compileCircuit().
+  // Gate i of the compiled form is gates[i], if buildGates() was run. Fanin and fanout lists are stored in CSR form.
+  vector<char> cGateType;         // Gate type of each gate (GATE_* macros)
+  vector<uint32_t> cFaninStart;   // Fanins of gate i are cFanin[cFaninStart[i]] .. cFanin[cFaninStart[i+1]-1]
+  vector<uint32_t> cFanin;        // Concatenated fanin gate indices of all gates
+  vector<uint32_t> cFanoutStart;  // Fanouts of gate i are cFanout[cFanoutStart[i]] .. cFanout[cFanoutStart[i+1]-1]
+  vector<uint32_t> cFanout;       // Concatenated fanout gate indices of all gates
+  vector<uint32_t> cInputs;       // Gate indices of the PIs
+  vector<uint32_t> cOutputs;      // Gate indices of the gates driving POs
+  vector<char> cIsOutput;         // 1 if gate i drives a PO
+  vector<uint32_t> cLevel;        // Topological level of each gate (PIs are level 0)
+  vector<uint32_t> cLevelOrder;   // All gate indices, sorted by increasing level
+  int numLevels;                  // Number of levels (the highest level + 1)
+  vector<int> cCC0;               // SCOAP 0-controllability of each gate's output
+  vector<int> cCC1;               // SCOAP 1-controllability of each gate's output
+  vector<int> cCO;                // SCOAP observability of each gate's output
+  vector<uint32_t> cGateName;     // Name index (in gateNames) of each gate's output name
 
+  // The arrays the accessors below read: the vectors above, or the sections of a mapped
+  // compiled file (see loadCompiled()), used in place.
+  const char* pGateType;
+  const uint32_t* pFaninStart;
+  const uint32_t* pFanin;
+  const uint32_t* pFanoutStart;
+  const uint32_t* pFanout;
+  const char* pIsOutput;
+  const uint32_t* pLevel;
+  const int* pCC0;
+  const int* pCC1;
+  const int* pCO;
+  const uint32_t* pGateName;
+  void* mapAddr;                  // The mapped compiled file (NULL if none)
+  size_t mapSize;                 // Its size in bytes
+
+  void compileCircuit();
+  void computeLevels();
+  void computeSCOAP();
+  void bindCompiled();
+  void checkHasGates() const;
   
  public:
   Circuit();
+  ~Circuit();
   void newGate(string name, int ID, int gt);
+  int internName(const char* s, int len);
+  bool newGate(int name, int gt);
+  void addGateInput(int name);
+  void addOutput(int name);
+  const char* getName(int name) const;
+  int getNameGate(int name) const;
   Gate* getGate(int i);
   void addOutputName(string n);
   void printAllGates();
   void setupCircuit();
+  void buildGates();
   Gate* findGateByName(string name);
+  int findGateIndexByName(const string& name);
   void setPIValues(vector<char> inputVals);
   vector<int> getPOValues();
   int getNumberPIs();
@@ -33,6 +95,26 @@ class Circuit{
   vector<Gate*> getPIGates();
   vector<Gate*> getPOGates();
   void clearFaults();
+
+  bool saveCompiled(const string& file, const string& source, bool withSCOAP) const;
+  bool loadCompiled(const string& file, const string& source, string& error);
+  const char* getGateName(int g) const;
+
+  // Access to the compiled form (valid after setupCircuit())
+  inline char getGateType(int g) const { return pGateType[g]; }
+  inline int getFaninCount(int g) const { return pFaninStart[g+1] - pFaninStart[g]; }
+  inline const uint32_t* getFanin(int g) const { return pFanin + pFaninStart[g]; }
+  inline int getFanoutCount(int g) const { return pFanoutStart[g+1] - pFanoutStart[g]; }
+  inline const uint32_t* getFanout(int g) const { return pFanout + pFanoutStart[g]; }
+  inline const vector<uint32_t>& getPIIndices() const { return cInputs; }
+  inline const vector<uint32_t>& getPOIndices() const { return cOutputs; }
+  inline bool isPOGate(int g) const { return pIsOutput[g]; }
+  inline int getLevel(int g) const { return pLevel[g]; }
+  inline int getNumberLevels() const { return numLevels; }
+  inline const vector<uint32_t>& getLevelOrder() const { return cLevelOrder; }
+  inline int getCC0(int g) const { return pCC0[g]; }
+  inline int getCC1(int g) const { return pCC1[g]; }
+  inline int getCO(int g) const { return pCO[g]; }
   
 };
 
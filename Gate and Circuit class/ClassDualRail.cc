@@ -0,0 +1,47 @@
+/** \struct DualRail
+ * \brief Word-parallel dual-rail encoding of D-calculus values.
+ *
+ * The good and faulty machines each carry a three-valued value as two bit planes ("is 1" and
+ * "is 0"), so a word holds 64 independent (good, faulty) pairs. Gate evaluation is then plain
+ * bitwise logic on the planes, for all lanes at once. FaultSim::simulateCubes() uses it to fault
+ * simulate test cubes that still contain X's, and AtpgEngine can use evalLogicGate() for
+ * implication (see AtpgEngine::setDualRail()).
+ */
+
+#include "ClassDualRail.h"
+#include "ClassParallelSim.h"
+#include <assert.h>  // assert
+
+#define ALL_ONES (~(uint64_t)0)
+
+const DualRail DualRail::logicRail[5] = {
+  { 0, ALL_ONES, 0, ALL_ONES },   // LOGIC_ZERO
+  { ALL_ONES, 0, ALL_ONES, 0 },   // LOGIC_ONE
+  { ALL_ONES, 0, 0, ALL_ONES },   // LOGIC_D
+  { 0, ALL_ONES, ALL_ONES, 0 },   // LOGIC_DBAR
+  { 0, 0, 0, 0 }                  // LOGIC_X
+};
+
+/** \brief Pack test cubes into dual-rail PI values for FaultSim::simulateCubes().
+ *  \param cubes The cubes (one 0, 1 or X per PI)
+ *  \param first The first cube to pack
+ *  \param count How many to pack (at most PATTERNS_PER_WORD); cube first+k goes in lane k
+ *  \param piRails Output: one value per PI, the same in the good and faulty machines
+ */
+void DualRail::packCubes(const vector<string>& cubes, int first, int count, vector<DualRail>& piRails) {
+  assert(count <= PATTERNS_PER_WORD);
+  piRails.assign(cubes[first].size(), logicRail[LOGIC_X]);
+  for (int k=0; k<count; k++) {
+    const string &c = cubes[first+k];
+    for (int i=0; i<c.size(); i++) {
+      if (c[i] == '1')
+        piRails[i].good1 |= (uint64_t)1 << k;
+      else if (c[i] == '0')
+        piRails[i].good0 |= (uint64_t)1 << k;
+    }
+  }
+  for (int i=0; i<piRails.size(); i++) {
+    piRails[i].faulty1 = piRails[i].good1;
+    piRails[i].faulty0 = piRails[i].good0;
+  }
+}
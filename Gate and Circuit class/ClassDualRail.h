@@ -0,0 +1,169 @@
+#ifndef CLASSDUALRAIL_H
+#define CLASSDUALRAIL_H
+
+#include "ClassGate.h"
+#include "ClassLogicKernel.h"
+#include <vector>    // vector
+#include <string>    // string
+#include <stdint.h>  // uint64_t, uint32_t
+using namespace std;
+
+/** \brief 64 D-calculus values, one per bit ("lane"), in dual-rail form.
+ *
+ * Each machine (good and faulty) gets two planes: bit k of good1 is set if the good value in
+ * lane k is 1, and bit k of good0 if it is 0. Neither bit set means X (both are never set).
+ * A 5-valued LOGIC_* value is a (good, faulty) pair: D is good 1 / faulty 0, D' is good 0 /
+ * faulty 1. The pair can also hold values the 5 values cannot, like good 1 / faulty X, which
+ * is what makes wide-gate evaluation exact (see LogicKernel).
+ *
+ * AND, OR, XOR and NOT of all 64 lanes, in both machines, are a few bitwise operations.
+ */
+struct DualRail {
+  uint64_t good1, good0, faulty1, faulty0;
+
+  // The dual-rail form of each LOGIC_* value, in every lane
+  static const DualRail logicRail[5];
+
+  /** \brief \a v (a LOGIC_* value, not LOGIC_UNSET) in every lane. */
+  static inline DualRail fromLogic(char v) { return logicRail[(int)v]; }
+
+  /** \brief The 5-valued value in lane \a k (LOGIC_X if either machine is X). */
+  inline char toLogic(int k) const {
+    int g = (good1 >> k) & 1 ? 1 : ((good0 >> k) & 1 ? 0 : 2);
+    int f = (faulty1 >> k) & 1 ? 1 : ((faulty0 >> k) & 1 ? 0 : 2);
+    return kernelValue(3*g + f);
+  }
+
+  /** \brief Lanes where the good and faulty values are both known and differ. */
+  inline uint64_t diff() const { return (good1 & faulty0) | (good0 & faulty1); }
+
+  inline bool operator==(const DualRail& b) const {
+    return (good1 == b.good1) && (good0 == b.good0) && (faulty1 == b.faulty1) && (faulty0 == b.faulty0);
+  }
+  inline bool operator!=(const DualRail& b) const { return !(*this == b); }
+
+  /** \brief Lane-wise AND: 1 if both are 1, 0 if either is 0. */
+  static inline DualRail opAnd(const DualRail& a, const DualRail& b) {
+    DualRail r = { a.good1 & b.good1, a.good0 | b.good0, a.faulty1 & b.faulty1, a.faulty0 | b.faulty0 };
+    return r;
+  }
+
+  /** \brief Lane-wise OR: 1 if either is 1, 0 if both are 0. */
+  static inline DualRail opOr(const DualRail& a, const DualRail& b) {
+    DualRail r = { a.good1 | b.good1, a.good0 & b.good0, a.faulty1 | b.faulty1, a.faulty0 & b.faulty0 };
+    return r;
+  }
+
+  /** \brief Lane-wise XOR: known only where both inputs are known. */
+  static inline DualRail opXor(const DualRail& a, const DualRail& b) {
+    DualRail r = { (a.good1 & b.good0) | (a.good0 & b.good1), (a.good1 & b.good1) | (a.good0 & b.good0),
+                   (a.faulty1 & b.faulty0) | (a.faulty0 & b.faulty1), (a.faulty1 & b.faulty1) | (a.faulty0 & b.faulty0) };
+    return r;
+  }
+
+  /** \brief Lane-wise NOT: swap the planes of each machine. */
+  static inline DualRail opNot(const DualRail& a) {
+    DualRail r = { a.good0, a.good1, a.faulty0, a.faulty1 };
+    return r;
+  }
+
+  /** \brief Combine \a a and \a b with KERNEL_AND, KERNEL_OR or KERNEL_XOR. */
+  template <int op>
+  static inline DualRail apply(const DualRail& a, const DualRail& b) {
+    return (op == KERNEL_AND) ? opAnd(a, b) : ((op == KERNEL_OR) ? opOr(a, b) : opXor(a, b));
+  }
+
+  template <int gateType>
+  static inline DualRail eval(const DualRail* values, const uint32_t* fanin, int n);
+  static inline DualRail evalGate(char gateType, const DualRail* values, const uint32_t* fanin, int n);
+
+  template <int gateType>
+  static inline char evalLogic(const char* values, const uint32_t* fanin, int n);
+  static inline char evalLogicGate(char gateType, const char* values, const uint32_t* fanin, int n);
+
+  static void packCubes(const vector<string>& cubes, int first, int count, vector<DualRail>& piRails);
+};
+
+/** \brief Evaluate a gate of type \a gateType in all 64 lanes.
+ *  \param values The dual-rail value of every gate
+ *  \param fanin The gate's fanin indices (see Circuit::getFanin())
+ *  \param n The number of fanins
+ *  \returns The gate's output (not including a possible fault on it)
+ */
+template <int gateType>
+inline DualRail DualRail::eval(const DualRail* values, const uint32_t* fanin, int n) {
+  const int op = GateKernel<gateType>::op;
+  DualRail r = values[fanin[0]];
+  for (int i=1; i<n; i++)
+    r = apply<op>(r, values[fanin[i]]);
+  return GateKernel<gateType>::invert ? opNot(r) : r;
+}
+
+template <>
+inline DualRail DualRail::eval<GATE_BUFF>(const DualRail* values, const uint32_t* fanin, int /*n*/) { return values[fanin[0]]; }
+
+template <>
+inline DualRail DualRail::eval<GATE_FANOUT>(const DualRail* values, const uint32_t* fanin, int /*n*/) { return values[fanin[0]]; }
+
+template <>
+inline DualRail DualRail::eval<GATE_NOT>(const DualRail* values, const uint32_t* fanin, int /*n*/) { return opNot(values[fanin[0]]); }
+
+/** \brief Evaluate a gate given its type at run time (see eval()). PIs are not evaluated. */
+inline DualRail DualRail::evalGate(char gateType, const DualRail* values, const uint32_t* fanin, int n) {
+  switch (gateType) {
+  case GATE_NAND: return eval<GATE_NAND>(values, fanin, n);
+  case GATE_NOR: return eval<GATE_NOR>(values, fanin, n);
+  case GATE_AND: return eval<GATE_AND>(values, fanin, n);
+  case GATE_OR: return eval<GATE_OR>(values, fanin, n);
+  case GATE_XOR: return eval<GATE_XOR>(values, fanin, n);
+  case GATE_XNOR: return eval<GATE_XNOR>(values, fanin, n);
+  case GATE_BUFF: return eval<GATE_BUFF>(values, fanin, n);
+  case GATE_NOT: return eval<GATE_NOT>(values, fanin, n);
+  case GATE_FANOUT: return eval<GATE_FANOUT>(values, fanin, n);
+  }
+  return fromLogic(LOGIC_X);
+}
+
+/** \brief Evaluate a gate of type \a gateType from 5-valued fanin values, through the dual-rail form.
+ *  \param values The LOGIC_* value of every gate
+ *  \param fanin The gate's fanin indices
+ *  \param n The number of fanins
+ *  \returns The gate's 5-valued output; the same as LogicKernel::eval()
+ *
+ * Only lane 0 is read back. Each fanin value is one table load and four bitwise operations.
+ */
+template <int gateType>
+inline char DualRail::evalLogic(const char* values, const uint32_t* fanin, int n) {
+  const int op = GateKernel<gateType>::op;
+  DualRail r = logicRail[(int)values[fanin[0]]];
+  for (int i=1; i<n; i++)
+    r = apply<op>(r, logicRail[(int)values[fanin[i]]]);
+  return (GateKernel<gateType>::invert ? opNot(r) : r).toLogic(0);
+}
+
+template <>
+inline char DualRail::evalLogic<GATE_BUFF>(const char* values, const uint32_t* fanin, int /*n*/) { return values[fanin[0]]; }
+
+template <>
+inline char DualRail::evalLogic<GATE_FANOUT>(const char* values, const uint32_t* fanin, int /*n*/) { return values[fanin[0]]; }
+
+template <>
+inline char DualRail::evalLogic<GATE_NOT>(const char* values, const uint32_t* fanin, int /*n*/) { return LogicKernel::logicNot(values[fanin[0]]); }
+
+/** \brief Evaluate a gate given its type at run time (see evalLogic()). PIs are not evaluated. */
+inline char DualRail::evalLogicGate(char gateType, const char* values, const uint32_t* fanin, int n) {
+  switch (gateType) {
+  case GATE_NAND: return evalLogic<GATE_NAND>(values, fanin, n);
+  case GATE_NOR: return evalLogic<GATE_NOR>(values, fanin, n);
+  case GATE_AND: return evalLogic<GATE_AND>(values, fanin, n);
+  case GATE_OR: return evalLogic<GATE_OR>(values, fanin, n);
+  case GATE_XOR: return evalLogic<GATE_XOR>(values, fanin, n);
+  case GATE_XNOR: return evalLogic<GATE_XNOR>(values, fanin, n);
+  case GATE_BUFF: return evalLogic<GATE_BUFF>(values, fanin, n);
+  case GATE_NOT: return evalLogic<GATE_NOT>(values, fanin, n);
+  case GATE_FANOUT: return evalLogic<GATE_FANOUT>(values, fanin, n);
+  }
+  return LOGIC_X;
+}
+
+#endif
@@ -0,0 +1,187 @@
+/** \class FaultList
+ * \brief Builds a collapsed list of single stuck-at faults for a circuit.
+ *
+ * Fault sites are the outputs of all gates of the set-up circuit: PIs, logic gates, and the
+ * FANOUT gates that setupCircuit() adds for each branch of a stem with fanout. Each site has
+ * a stuck-at-0 and a stuck-at-1 fault, so this universe has two faults per gate.
+ *
+ * \a build() first merges structurally equivalent faults and keeps one of each class.
+ * A gate input is equivalent to a gate output only when the input line is the whole
+ * output of the driving gate (it drives nothing else, and is not a PO); otherwise the
+ * input line is a FANOUT branch, which is its own site. The rules are:
+ *  - AND: input s-a-0 == output s-a-0;  NAND: input s-a-0 == output s-a-1
+ *  - OR:  input s-a-1 == output s-a-1;  NOR:  input s-a-1 == output s-a-0
+ *  - BUFF and FANOUT: input s-a-v == output s-a-v;  NOT: input s-a-v == output s-a-(not v)
+ *
+ * Optionally, it then removes faults that dominate another fault in the list, since any test
+ * for the dominated fault also detects them: the output s-a-1 of AND and NOR, and the output
+ * s-a-0 of NAND and OR, each dominate the matching fault on an input line. A fault is only removed
+ * if a fault it dominates stays in the list. Note that if that dominated fault is untestable,
+ * the removed fault may still have been testable.
+ */
+
+#include "ClassFaultList.h"
+
+/** \brief Construct an empty fault list for a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+FaultList::FaultList(const Circuit* c) {
+  circuit = c;
+  numUncollapsed = 0;
+}
+
+/** \brief Find the representative of the class of fault \a u (with path halving). */
+int FaultList::findClass(int u) {
+  while (classOf[u] != u) {
+    classOf[u] = classOf[classOf[u]];
+    u = classOf[u];
+  }
+  return u;
+}
+
+/** \brief Merge the classes of faults \a u and \a v. */
+void FaultList::mergeClasses(int u, int v) {
+  u = findClass(u);
+  v = findClass(v);
+  if (u != v)
+    classOf[u] = v;
+}
+
+/** \brief Returns true if the output of gate \a g is a single line into one gate input, so a fault on it is that input's fault. */
+bool FaultList::lineFault(int g) {
+  return (circuit->getFanoutCount(g) == 1) && !circuit->isPOGate(g);
+}
+
+/** \brief Build the collapsed fault list.
+ *  \param dominance If true, also remove faults by dominance
+ *
+ * Faults are listed in gate order, stuck-at-0 before stuck-at-1. Each kept class is listed
+ * once, at the fault of the class that is closest to the POs (highest level).
+ */
+void FaultList::build(bool dominance) {
+  int numGates = circuit->getLevelOrder().size();
+  numUncollapsed = 2 * numGates;
+
+  classOf.resize(numUncollapsed);
+  for (int u=0; u<numUncollapsed; u++)
+    classOf[u] = u;
+
+  // equivalence collapsing
+  for (int g=0; g<numGates; g++) {
+    char t = circuit->getGateType(g);
+    const uint32_t* fanin = circuit->getFanin(g);
+    int numFanin = circuit->getFaninCount(g);
+
+    for (int i=0; i<numFanin; i++) {
+      int a = fanin[i];
+      if (!lineFault(a))
+        continue;
+
+      switch(t) {
+      case GATE_AND:  { mergeClasses(2*a + FAULT_SA0, 2*g + FAULT_SA0); break; }
+      case GATE_NAND: { mergeClasses(2*a + FAULT_SA0, 2*g + FAULT_SA1); break; }
+      case GATE_OR:   { mergeClasses(2*a + FAULT_SA1, 2*g + FAULT_SA1); break; }
+      case GATE_NOR:  { mergeClasses(2*a + FAULT_SA1, 2*g + FAULT_SA0); break; }
+      case GATE_BUFF:
+      case GATE_FANOUT: {
+        mergeClasses(2*a + FAULT_SA0, 2*g + FAULT_SA0);
+        mergeClasses(2*a + FAULT_SA1, 2*g + FAULT_SA1);
+        break;
+      }
+      case GATE_NOT: {
+        mergeClasses(2*a + FAULT_SA0, 2*g + FAULT_SA1);
+        mergeClasses(2*a + FAULT_SA1, 2*g + FAULT_SA0);
+        break;
+      }
+      default: break;
+      }
+    }
+  }
+
+  // removed[c] is 1 if class c (a representative) is dropped by dominance
+  vector<char> removed(numUncollapsed, 0);
+
+  if (dominance) {
+    // dominated[k] lists, for candidate class candidate[k], the classes it dominates
+    vector<int> candidate;
+    vector< vector<int> > dominated;
+
+    for (int g=0; g<numGates; g++) {
+      char t = circuit->getGateType(g);
+      char outFault, inFault;
+      if (t == GATE_AND)       { outFault = FAULT_SA1; inFault = FAULT_SA1; }
+      else if (t == GATE_NAND) { outFault = FAULT_SA0; inFault = FAULT_SA1; }
+      else if (t == GATE_OR)   { outFault = FAULT_SA0; inFault = FAULT_SA0; }
+      else if (t == GATE_NOR)  { outFault = FAULT_SA1; inFault = FAULT_SA0; }
+      else
+        continue;
+
+      int c = findClass(2*g + outFault);
+      vector<int> d;
+      const uint32_t* fanin = circuit->getFanin(g);
+      int numFanin = circuit->getFaninCount(g);
+      for (int i=0; i<numFanin; i++) {
+        int ci = findClass(2*fanin[i] + inFault);
+        if (lineFault(fanin[i]) && (ci != c))
+          d.push_back(ci);
+      }
+      if (d.empty())
+        continue;
+
+      candidate.push_back(c);
+      dominated.push_back(d);
+      removed[c] = 1;
+    }
+
+    // Put back any removed class that no longer dominates a kept class, until nothing changes.
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int k=0; k<candidate.size(); k++) {
+        int c = candidate[k];
+        if (!removed[c])
+          continue;
+        bool anyKept = false;
+        for (int i=0; i<dominated[k].size(); i++)
+          if (!removed[dominated[k][i]])
+            anyKept = true;
+        if (!anyKept) {
+          removed[c] = 0;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // pick the fault of each kept class that is closest to the POs
+  vector<int> best(numUncollapsed, -1);
+  for (int u=0; u<numUncollapsed; u++) {
+    int c = findClass(u);
+    if (removed[c])
+      continue;
+    if ((best[c] == -1) || (circuit->getLevel(u/2) > circuit->getLevel(best[c]/2)))
+      best[c] = u;
+  }
+
+  faultGate.clear();
+  faultType.clear();
+  for (int u=0; u<numUncollapsed; u++) {
+    int c = findClass(u);
+    if (!removed[c] && (best[c] == u)) {
+      faultGate.push_back(u/2);
+      faultType.push_back(u%2);
+    }
+  }
+}
+
+/** \brief Get the number of faults in the collapsed list. */
+int FaultList::getNumberFaults() const { return faultGate.size(); }
+
+/** \brief Get the number of faults before collapsing (two per gate). */
+int FaultList::getNumberUncollapsed() const { return numUncollapsed; }
+
+/** \brief Get the gate whose output has fault \a f. */
+int FaultList::getFaultGate(int f) const { return faultGate[f]; }
+
+/** \brief Get the type (FAULT_SA0 or FAULT_SA1) of fault \a f. */
+char FaultList::getFaultType(int f) const { return faultType[f]; }
@@ -0,0 +1,31 @@
+#ifndef CLASSFAULTLIST_H
+#define CLASSFAULTLIST_H
+
+#include "ClassCircuit.h"
+#include <vector>    // vector
+using namespace std;
+
+class FaultList{
+
+ private:
+  const Circuit* circuit;      // The circuit the faults are in
+  vector<int> faultGate;       // Gate whose output has fault f
+  vector<char> faultType;      // FAULT_SA0 or FAULT_SA1 for fault f
+  int numUncollapsed;          // Number of faults before collapsing
+
+  vector<int> classOf;         // Union-find parent of each fault of the universe (2*gate + type)
+  int findClass(int u);
+  void mergeClasses(int u, int v);
+  bool lineFault(int g);
+
+ public:
+  FaultList(const Circuit* c);
+  void build(bool dominance);
+
+  int getNumberFaults() const;
+  int getNumberUncollapsed() const;
+  int getFaultGate(int f) const;
+  char getFaultType(int f) const;
+};
+
+#endif
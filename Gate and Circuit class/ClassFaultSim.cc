@@ -0,0 +1,235 @@
+/** \class FaultSim
+ * \brief A parallel-pattern single-fault propagation (PPSFP) stuck-at fault simulator.
+ *
+ * The fault simulator holds a list of single stuck-at faults (each one a gate output and a
+ * stuck value, as in the fault files) and remembers which of them have been detected.
+ * \a simulate() takes up to 64 fully specified patterns, packed one per bit as for
+ * ParallelSim. It first simulates the good machine, then, for every fault not yet detected,
+ * injects the fault and propagates its effect through the fault's fanout cone only, in level
+ * order, stopping wherever the faulty value stops differing from the good value. A fault is
+ * detected by a pattern if the faulty and good values differ on some PO for that pattern.
+ *
+ * Detected faults are dropped: later calls to \a simulate() do not simulate them again.
+ *
+ * \a simulateCubes() does the same for test cubes that may contain X's, using the dual-rail
+ * encoding (see DualRail). A cube detects a fault only if it does for every way of filling its
+ * X's, which is what the three-valued good and faulty values tell us.
+ */
+
+#include "ClassFaultSim.h"
+
+/** \brief Construct a fault simulator with an empty fault list.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+FaultSim::FaultSim(const Circuit* c) : goodSim(c) {
+  circuit = c;
+  numDetected = 0;
+  queue.init(c);
+}
+
+/** \brief Add a fault to the fault list.
+ *  \param g The gate whose output is faulty
+ *  \param type FAULT_SA0 or FAULT_SA1
+ *  \return The fault's number, used in the other functions
+ */
+int FaultSim::addFault(int g, char type) {
+  assert((type == FAULT_SA0) || (type == FAULT_SA1));
+  faultGate.push_back(g);
+  faultType.push_back(type);
+  detected.push_back(0);
+  return faultGate.size() - 1;
+}
+
+/** \brief Get the number of faults in the fault list. */
+int FaultSim::getNumberFaults() const { return faultGate.size(); }
+
+/** \brief Get the number of faults detected so far. */
+int FaultSim::getNumberDetected() const { return numDetected; }
+
+/** \brief Returns true if fault \a f has been detected (and is no longer simulated). */
+bool FaultSim::isDetected(int f) const { return detected[f]; }
+
+/** \brief Mark fault \a f as detected, so it is no longer simulated. */
+void FaultSim::setDetected(int f) {
+  if (!detected[f]) {
+    detected[f] = 1;
+    numDetected++;
+  }
+}
+
+/** \brief Mark every fault as not detected. */
+void FaultSim::clearDetected() {
+  fill(detected.begin(), detected.end(), 0);
+  numDetected = 0;
+}
+
+/** \brief Get the gate whose output has fault \a f. */
+int FaultSim::getFaultGate(int f) const { return faultGate[f]; }
+
+/** \brief Get the type (FAULT_SA0 or FAULT_SA1) of fault \a f. */
+char FaultSim::getFaultType(int f) const { return faultType[f]; }
+
+/** \brief Simulate up to 64 patterns against every fault not yet detected.
+ *  \param piWords One word per PI (in the order of Circuit::getPIIndices()); bit \a k is pattern \a k
+ *  \param mask Bit \a k is set if pattern \a k is used
+ *  \return The number of faults newly detected. They are marked detected, and listed
+ *  (with the patterns that detect each one) by getLastDetected() and getLastDetectWords().
+ */
+int FaultSim::simulate(const vector<uint64_t>& piWords, uint64_t mask) {
+  goodSim.setPIWords(piWords);
+  goodSim.simulate();
+  work = goodSim.getWords();
+
+  lastDetected.clear();
+  lastDetectWords.clear();
+  for (int f=0; f<faultGate.size(); f++) {
+    if (detected[f])
+      continue;
+    uint64_t det = simulateFault(f, mask);
+    if (det != 0) {
+      setDetected(f);
+      lastDetected.push_back(f);
+      lastDetectWords.push_back(det);
+    }
+  }
+  return lastDetected.size();
+}
+
+/** \brief Propagate one fault through its fanout cone, for the patterns last given to simulate().
+ *  \param f The fault
+ *  \param mask Bit \a k is set if pattern \a k is used
+ *  \return Bit \a k is set if pattern \a k detects fault \a f
+ *  \note This does not change whether \a f is marked detected.
+ */
+uint64_t FaultSim::simulateFault(int f, uint64_t mask) {
+  int site = faultGate[f];
+  uint64_t stuck = (faultType[f] == FAULT_SA1) ? ~(uint64_t)0 : 0;
+  
+  // the patterns that activate the fault
+  if (((work[site] ^ stuck) & mask) == 0)
+    return 0;
+
+  uint64_t det = 0;
+  const vector<uint64_t>& good = goodSim.getWords();
+  touched.clear();
+
+  touched.push_back(make_pair(site, work[site]));
+  work[site] = stuck;
+  if (circuit->isPOGate(site))
+    det |= (stuck ^ good[site]) & mask;
+  queue.pushFanouts(site);
+
+  // Gates are popped in level order, so each gate in the cone is evaluated once,
+  // after all of its faulty fanins.
+  int g;
+  while ((g = queue.pop()) != -1) {
+    uint64_t v = ParallelSim::evalGate(circuit, g, &work[0]);
+    if (v == work[g])
+      continue;
+    touched.push_back(make_pair(g, work[g]));
+    work[g] = v;
+    if (circuit->isPOGate(g))
+      det |= (v ^ good[g]) & mask;
+    queue.pushFanouts(g);
+  }
+
+  // put the good values back
+  for (int i=touched.size()-1; i>=0; i--)
+    work[touched[i].first] = touched[i].second;
+
+  return det;
+}
+
+/** \brief Simulate up to 64 test cubes (with X's) against every fault not yet detected.
+ *  \param piRails One value per PI (see DualRail::packCubes()); lane \a k is cube \a k
+ *  \param mask Bit \a k is set if cube \a k is used
+ *  \return The number of faults newly detected (by every fill of the cube's X's). They are
+ *  marked detected and listed by getLastDetected() and getLastDetectWords(), as for simulate().
+ */
+int FaultSim::simulateCubes(const vector<DualRail>& piRails, uint64_t mask) {
+  const vector<uint32_t>& pis = circuit->getPIIndices();
+  const vector<uint32_t>& order = circuit->getLevelOrder();
+  railGood.resize(order.size());
+  for (int i=0; i<pis.size(); i++)
+    railGood[pis[i]] = piRails[i];
+  for (int k=0; k<order.size(); k++) {
+    int g = order[k];
+    if (circuit->getGateType(g) != GATE_PI)
+      railGood[g] = DualRail::evalGate(circuit->getGateType(g), &railGood[0], circuit->getFanin(g), circuit->getFaninCount(g));
+  }
+  railWork = railGood;
+
+  lastDetected.clear();
+  lastDetectWords.clear();
+  for (int f=0; f<faultGate.size(); f++) {
+    if (detected[f])
+      continue;
+    uint64_t det = simulateCubeFault(f, mask);
+    if (det != 0) {
+      setDetected(f);
+      lastDetected.push_back(f);
+      lastDetectWords.push_back(det);
+    }
+  }
+  return lastDetected.size();
+}
+
+/** \brief Propagate one fault through its fanout cone, for the cubes last given to simulateCubes().
+ *  \param f The fault
+ *  \param mask Bit \a k is set if cube \a k is used
+ *  \return Bit \a k is set if cube \a k detects fault \a f however its X's are filled
+ *  \note This does not change whether \a f is marked detected.
+ */
+uint64_t FaultSim::simulateCubeFault(int f, uint64_t mask) {
+  int site = faultGate[f];
+  DualRail v = railWork[site];
+
+  // The cubes that surely activate the fault. (If the good value is X, some fill
+  // gives it the stuck value, and then that fill does not detect the fault.)
+  uint64_t act;
+  if (faultType[f] == FAULT_SA1) {
+    act = v.good0;
+    v.faulty1 = ~(uint64_t)0;
+    v.faulty0 = 0;
+  }
+  else {
+    act = v.good1;
+    v.faulty1 = 0;
+    v.faulty0 = ~(uint64_t)0;
+  }
+  if ((act & mask) == 0)
+    return 0;
+
+  uint64_t det = 0;
+  railTouched.clear();
+
+  railTouched.push_back(make_pair(site, railWork[site]));
+  railWork[site] = v;
+  if (circuit->isPOGate(site))
+    det |= v.diff() & mask;
+  queue.pushFanouts(site);
+
+  int g;
+  while ((g = queue.pop()) != -1) {
+    v = DualRail::evalGate(circuit->getGateType(g), &railWork[0], circuit->getFanin(g), circuit->getFaninCount(g));
+    if (v == railWork[g])
+      continue;
+    railTouched.push_back(make_pair(g, railWork[g]));
+    railWork[g] = v;
+    if (circuit->isPOGate(g))
+      det |= v.diff() & mask;
+    queue.pushFanouts(g);
+  }
+
+  // put the good values back
+  for (int i=railTouched.size()-1; i>=0; i--)
+    railWork[railTouched[i].first] = railTouched[i].second;
+
+  return det;
+}
+
+/** \brief Get the faults newly detected by the last simulate() or simulateCubes() call. */
+const vector<int>& FaultSim::getLastDetected() const { return lastDetected; }
+
+/** \brief Get, for each fault in getLastDetected(), the word of patterns that detect it. */
+const vector<uint64_t>& FaultSim::getLastDetectWords() const { return lastDetectWords; }
@@ -0,0 +1,53 @@
+#ifndef CLASSFAULTSIM_H
+#define CLASSFAULTSIM_H
+
+#include "ClassCircuit.h"
+#include "ClassParallelSim.h"
+#include "ClassLevelQueue.h"
+#include "ClassDualRail.h"
+#include <vector>    // vector
+#include <stdint.h>  // uint64_t
+using namespace std;
+
+class FaultSim{
+
+ private:
+  const Circuit* circuit;        // The circuit being simulated
+  ParallelSim goodSim;           // Good-machine simulator for the current patterns
+  vector<int> faultGate;         // Gate whose output has fault f
+  vector<char> faultType;        // FAULT_SA0 or FAULT_SA1 for fault f
+  vector<char> detected;         // 1 once fault f has been detected
+  int numDetected;               // Number of faults detected so far
+
+  vector<uint64_t> work;         // Good values, overwritten with faulty values inside one fault's cone
+  vector< pair<int, uint64_t> > touched; // Gates changed in work (and their good values), to restore after each fault
+  LevelQueue queue;              // Levelized queue used to propagate a fault through its fanout cone
+
+  vector<DualRail> railGood;     // Dual-rail good values of each gate for the cubes given to simulateCubes()
+  vector<DualRail> railWork;     // railGood, overwritten with faulty values inside one fault's cone
+  vector< pair<int, DualRail> > railTouched; // Gates changed in railWork (and their good values)
+
+  vector<int> lastDetected;      // Faults newly detected by the last simulate() call
+  vector<uint64_t> lastDetectWords; // For each of those, the patterns that detect it
+
+ public:
+  FaultSim(const Circuit* c);
+
+  int addFault(int g, char type);
+  int getNumberFaults() const;
+  int getNumberDetected() const;
+  bool isDetected(int f) const;
+  void setDetected(int f);
+  void clearDetected();
+  int getFaultGate(int f) const;
+  char getFaultType(int f) const;
+
+  int simulate(const vector<uint64_t>& piWords, uint64_t mask);
+  uint64_t simulateFault(int f, uint64_t mask);
+  int simulateCubes(const vector<DualRail>& piRails, uint64_t mask);
+  uint64_t simulateCubeFault(int f, uint64_t mask);
+  const vector<int>& getLastDetected() const;
+  const vector<uint64_t>& getLastDetectWords() const;
+};
+
+#endif
@@ -48,6 +48,11 @@ Gate::Gate(string name, int ID, int gt) {
   gateValue = LOGIC_UNSET;
 }
   
+/** \brief Get the unique ID of this gate.
+ *  \return The gate ID. After setupCircuit(), this is also the gate's index in its Circuit.
+ */
+int Gate::get_gateID() { return gateID; }
+
 /** \brief Get the gate type for this gate.
  *  \return The gate type, using the GATE_* macros defined in ClassGate.h
  */
@@ -208,21 +213,6 @@ string Gate::printValue() {
 }
 
 
-/** \brief Stores the name of one of this gate's input signals.
- *  \param n The name of one of this gate's inputs.
- *  \note Normally, this code should only need to be run by the parser, and its results should only need to be used by the setupCircuit() function of Circut. You should never need to touch this.
- */
-void Gate::set_gateInputName(string n) {
-  inputName.push_back(n);
-}
-
-/** \brief Gets the pre-stored names of this gate's input signals. 
- *  Normally, this code should only need to be run by the setupCircuit() function of Circut.
- */
-vector<string> Gate::get_gateInputNames() {
-  return inputName;
-}
-
 /** \brief Finds which of this gate's inputs is connected to the output of Gate \a g.
  *  \param g Pointer to the \a Gate we are searching for
  *  \return An integer value, showing which of this gate's inputs (numbered starting at 0) is connect to \a Gate \a g.
@@ -47,13 +47,13 @@ class Gate{
   char gateValue;            // The logic value of this gate's output (using macros above: LOGIC_ZERO, etc.
 
   string printLogicVal(int val);
-  vector<string> inputName;  // A list of the names of the inputs to this gate.
 
   char faultType;            // Type of fault on this gate's output (NOFAULT, FAULT_SA0, FAULT_SA1)
 
  public:
   Gate(string name, int ID, int gt);
   
+  int get_gateID();
   char get_gateType();
 
   vector<Gate*> get_gateOutputs();
@@ -73,9 +73,6 @@ class Gate{
   char getValue();
   string printValue();
 
-  void set_gateInputName(string n);
-  vector<string> get_gateInputNames();
-
   int getGateInputNumber(Gate *g);
 
   void set_faultType(char f);
@@ -0,0 +1,267 @@
+/** \class ImplicationTable
+ * \brief Indirect implications found by static learning (as in SOCRATES).
+ *
+ * \a learn() sets each gate in turn to 0 and to 1 and finds the values this implies, forward
+ * and backward (see implyAll()). Whenever it implies a value w on a gate h that only arises if
+ * all of h's inputs are non-controlling (1 on an AND, 0 on a NAND, ...), "g = v implies h = w"
+ * is learned together with its contrapositive "h = not w implies g = not v". The contrapositive
+ * is what local implication cannot find: with h at the controlled value, no single input of h
+ * is known.
+ *
+ * The table is built once and only read afterwards, so all engines can share it. It can be
+ * saved to a file and loaded again for the same circuit instead of learning it again.
+ */
+
+#include "ClassImplicationTable.h"
+#include "ClassLogicKernel.h"
+#include <fstream>   // ifstream, ofstream
+#include <algorithm> // sort, unique
+
+/** \brief Get the good-machine value (LOGIC_ZERO, LOGIC_ONE or LOGIC_X) of a 5-valued value. */
+static char goodValue(char v) {
+  if (v == LOGIC_D)
+    return LOGIC_ONE;
+  if (v == LOGIC_DBAR)
+    return LOGIC_ZERO;
+  return v;
+}
+
+/** \brief Get the output value gate type \a type has when no input is controlling (-1 if there is none). */
+static int nonControlledValue(char type) {
+  switch (type) {
+  case GATE_AND: return LOGIC_ONE;
+  case GATE_NAND: return LOGIC_ZERO;
+  case GATE_OR: return LOGIC_ZERO;
+  case GATE_NOR: return LOGIC_ONE;
+  }
+  return -1;
+}
+
+/** \brief Construct an empty table for a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+ImplicationTable::ImplicationTable(const Circuit* c) {
+  circuit = c;
+  numLearned = 0;
+  start.assign(2*c->getLevelOrder().size() + 1, 0);
+}
+
+/** \brief Get the number of learned implications. */
+int ImplicationTable::getNumberLearned() const { return numLearned; }
+
+/** \brief Set gate \a g to \a v during implication (see implyAll()).
+ *  \returns false if g already has the other value.
+ */
+bool ImplicationTable::assign(int g, char v, vector<char> &values, vector<int> &touched) {
+  if (values[g] == v)
+    return true;
+  if (values[g] != LOGIC_X)
+    return false;
+  values[g] = v;
+  touched.push_back(g);
+  return true;
+}
+
+/** \brief Find all values implied by the values of \a touched[first..], forward and backward.
+ *  \param values The value of each gate (LOGIC_ZERO, LOGIC_ONE or LOGIC_X); implied values are set here
+ *  \param touched The gates set so far; implied gates are added
+ *  \returns false if the values are contradictory
+ *
+ * Forward, a gate's value follows from its inputs. Backward, an output value that has only
+ * one justification sets the inputs: all of them (1 on an AND, ...), or the last X input when
+ * the others are all non-controlling (0 on an AND, ...), or the last X input of an XOR.
+ */
+bool ImplicationTable::implyAll(vector<char> &values, vector<int> &touched) {
+  for (int t=0; t<touched.size(); t++) {
+    int g = touched[t];
+
+    // g and its fanouts may now imply something
+    const uint32_t* fo = circuit->getFanout(g);
+    int numFo = circuit->getFanoutCount(g);
+    for (int j=-1; j<numFo; j++) {
+      int h = (j < 0) ? g : fo[j];
+
+      char out = LOGIC_X;
+      if (circuit->getGateType(h) != GATE_PI)
+        out = LogicKernel::evalGate(circuit->getGateType(h), &values[0], circuit->getFanin(h), circuit->getFaninCount(h));
+      if ((out != LOGIC_X) && !assign(h, out, values, touched))
+        return false;
+      if (values[h] == LOGIC_X)
+        continue;
+
+      const uint32_t* pred = circuit->getFanin(h);
+      int numPred = circuit->getFaninCount(h);
+      char type = circuit->getGateType(h);
+      switch (type) {
+      case GATE_BUFF: case GATE_FANOUT:
+        if (!assign(pred[0], values[h], values, touched))
+          return false;
+        break;
+      case GATE_NOT:
+        if (!assign(pred[0], 1 - values[h], values, touched))
+          return false;
+        break;
+      case GATE_AND: case GATE_NAND: case GATE_OR: case GATE_NOR: {
+        int c = ((type == GATE_AND) || (type == GATE_NAND)) ? LOGIC_ZERO : LOGIC_ONE;
+        int inv = ((type == GATE_NAND) || (type == GATE_NOR)) ? 1 : 0;
+        if ((values[h] ^ inv) != c) {
+          for (int i=0; i<numPred; i++)
+            if (!assign(pred[i], 1 - c, values, touched))
+              return false;
+        }
+        else {
+          int last = -1, numX = 0;
+          bool controlled = false;
+          for (int i=0; i<numPred; i++) {
+            if (values[pred[i]] == LOGIC_X) {
+              numX++;
+              last = pred[i];
+            }
+            else if (values[pred[i]] == c)
+              controlled = true;
+          }
+          if (!controlled && (numX == 1) && !assign(last, c, values, touched))
+            return false;
+        }
+        break;
+      }
+      case GATE_XOR: case GATE_XNOR: {
+        int last = -1, numX = 0, parity = (type == GATE_XNOR) ? 1 : 0;
+        for (int i=0; i<numPred; i++) {
+          if (values[pred[i]] == LOGIC_X) {
+            numX++;
+            last = pred[i];
+          }
+          else
+            parity ^= values[pred[i]];
+        }
+        if ((numX == 1) && !assign(last, values[h] ^ parity, values, touched))
+          return false;
+        break;
+      }
+      }
+    }
+  }
+  return true;
+}
+
+/** \brief Learn the indirect implications of every gate value (see the class description).
+ *
+ * Values are implied forward and backward (see implyAll()). If a value leads to a
+ * contradiction, nothing is learned from it. Fanout branches are skipped, since they have the
+ * same value as their stem.
+ */
+void ImplicationTable::learn() {
+  int n = circuit->getLevelOrder().size();
+  vector<char> values(n, LOGIC_X);
+  vector<int> touched;
+  vector< pair<uint32_t, uint32_t> > pairs;
+
+  for (int g=0; g<n; g++) {
+    if (circuit->getGateType(g) == GATE_FANOUT)
+      continue;
+
+    for (int v=LOGIC_ZERO; v<=LOGIC_ONE; v++) {
+      assign(g, v, values, touched);
+      if (implyAll(values, touched)) {
+        for (int i=1; i<touched.size(); i++) {
+          int h = touched[i];
+          int w = values[h];
+          if (w == nonControlledValue(circuit->getGateType(h))) {
+            pairs.push_back(make_pair(implLiteral(g, v), implLiteral(h, w)));
+            pairs.push_back(make_pair(implLiteral(h, 1-w), implLiteral(g, 1-v)));
+          }
+        }
+      }
+
+      for (int i=0; i<touched.size(); i++)
+        values[touched[i]] = LOGIC_X;
+      touched.clear();
+    }
+  }
+
+  build(pairs);
+}
+
+/** \brief Rebuild the table from (literal, implied literal) pairs; duplicates are removed. */
+void ImplicationTable::build(vector< pair<uint32_t, uint32_t> > &pairs) {
+  sort(pairs.begin(), pairs.end());
+  pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+  fill(start.begin(), start.end(), 0);
+  implied.resize(pairs.size());
+  for (int i=0; i<pairs.size(); i++)
+    start[pairs[i].first + 1]++;
+  for (int l=1; l<start.size(); l++)
+    start[l] += start[l-1];
+  for (int i=0; i<pairs.size(); i++)
+    implied[i] = pairs[i].second;   // pairs are sorted by literal
+  numLearned = pairs.size() / 2;
+}
+
+/** \brief Returns true if the learned implications force gate \a g to value \a v.
+ *  \param g The gate
+ *  \param v LOGIC_ZERO or LOGIC_ONE
+ *  \param values The current (5-valued) values of all gates; only their good-machine values are used
+ *
+ * g is forced to v if some gate has a value that implies it, i.e. (by the contrapositive,
+ * which is also in the table) if "g = not v" implies a literal that is currently false.
+ */
+bool ImplicationTable::isForced(int g, char v, const vector<char> &values) const {
+  uint32_t l = implLiteral(g, 1-v);
+  for (uint32_t i=start[l]; i<start[l+1]; i++) {
+    char gv = goodValue(values[implied[i] >> 1]);
+    if ((gv != LOGIC_X) && (gv != (implied[i] & 1)))
+      return true;
+  }
+  return false;
+}
+
+/** \brief Save the table (as text: a header, then one "gate value gate value" line per implication).
+ *  \returns false if the file cannot be written.
+ */
+bool ImplicationTable::save(const string &fileName) const {
+  ofstream out(fileName.c_str());
+  if (!out.is_open())
+    return false;
+
+  out << "# learned implications: gate value => gate value" << endl;
+  out << "gates " << circuit->getLevelOrder().size() << endl;
+  for (uint32_t l=0; l+1<start.size(); l++)
+    for (uint32_t i=start[l]; i<start[l+1]; i++)
+      out << (l >> 1) << " " << (l & 1) << " " << (implied[i] >> 1) << " " << (implied[i] & 1) << endl;
+  return true;
+}
+
+/** \brief Load a table written by save() (for the same circuit).
+ *  \returns false if the file cannot be read, or was saved for a circuit with a different
+ *  number of gates. The table is then left empty.
+ */
+bool ImplicationTable::load(const string &fileName) {
+  vector< pair<uint32_t, uint32_t> > pairs;
+  build(pairs);
+
+  ifstream in(fileName.c_str());
+  if (!in.is_open())
+    return false;
+
+  string line, word;
+  long numGates = -1;
+  while (getline(in, line) && (line.empty() || (line[0] == '#')))
+    ;
+  istringstream header(line);
+  if (!(header >> word >> numGates) || (word != "gates") || (numGates != circuit->getLevelOrder().size()))
+    return false;
+
+  long g, v, h, w;
+  while (in >> g >> v >> h >> w) {
+    if ((g < 0) || (g >= numGates) || (h < 0) || (h >= numGates) || (v & ~1) || (w & ~1))
+      return false;
+    pairs.push_back(make_pair(implLiteral(g, v), implLiteral(h, w)));
+  }
+  if (!in.eof())
+    return false;
+
+  build(pairs);
+  return true;
+}
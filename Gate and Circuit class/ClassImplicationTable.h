@@ -0,0 +1,36 @@
+#ifndef CLASSIMPLICATIONTABLE_H
+#define CLASSIMPLICATIONTABLE_H
+
+#include "ClassCircuit.h"
+#include <vector>    // vector
+#include <string>    // string
+#include <stdint.h>  // uint32_t
+using namespace std;
+
+/** \brief The literal "gate \a g has value \a v" (v is LOGIC_ZERO or LOGIC_ONE) in an ImplicationTable. */
+inline uint32_t implLiteral(int g, int v) { return 2*g + v; }
+
+class ImplicationTable{
+
+ private:
+  const Circuit* circuit;     // The circuit (shared, never modified)
+  vector<uint32_t> start;     // Implications of literal l are implied[start[l]] .. implied[start[l+1]-1]
+  vector<uint32_t> implied;   // Implied literals of all literals
+  int numLearned;             // Number of learned implications (each is stored with its contrapositive)
+
+  void build(vector< pair<uint32_t, uint32_t> > &pairs);
+  bool assign(int g, char v, vector<char> &values, vector<int> &touched);
+  bool implyAll(vector<char> &values, vector<int> &touched);
+
+ public:
+  ImplicationTable(const Circuit* c);
+
+  void learn();
+  bool save(const string &fileName) const;
+  bool load(const string &fileName);
+
+  int getNumberLearned() const;
+  bool isForced(int g, char v, const vector<char> &values) const;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/** \class LevelQueue
+ * \brief A levelized event queue for event-driven simulation.
+ *
+ * The queue keeps one bucket of gates per topological level of the circuit (see
+ * Circuit::getLevel()), and a flag per gate saying whether it is already in a bucket.
+ * \a pop() always returns a gate from the lowest non-empty level. Because a gate's fanouts
+ * are always at a higher level than the gate, by the time a gate is popped all of its
+ * scheduled fanins have already been evaluated. Together with the flag, which makes a second
+ * \a push() of a waiting gate do nothing, this means each gate is evaluated at most once per
+ * propagation wave, even where paths reconverge.
+ */
+
+#include "ClassLevelQueue.h"
+
+/** \brief Construct an empty queue. Call \a init() before using it. */
+LevelQueue::LevelQueue() {
+  circuit = NULL;
+  currentLevel = 0;
+  numScheduled = 0;
+}
+
+/** \brief Set up the buckets for a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+void LevelQueue::init(const Circuit* c) {
+  circuit = c;
+  bucket.assign(c->getNumberLevels(), vector<uint32_t>());
+  scheduled.assign(c->getLevelOrder().size(), 0);
+  currentLevel = c->getNumberLevels();
+  numScheduled = 0;
+}
+
+/** \brief Schedule all the fanouts of gate \a g (e.g. after the value of \a g has changed). */
+void LevelQueue::pushFanouts(int g) {
+  const uint32_t* fo = circuit->getFanout(g);
+  int n = circuit->getFanoutCount(g);
+  for (int j=0; j<n; j++)
+    push(fo[j]);
+}
+
+/** \brief Remove and return a gate from the lowest non-empty level.
+ *  \return The gate index, or -1 if the queue is empty.
+ */
+int LevelQueue::pop() {
+  if (numScheduled == 0)
+    return -1;
+  while (bucket[currentLevel].empty())
+    currentLevel++;
+  int g = bucket[currentLevel].back();
+  bucket[currentLevel].pop_back();
+  scheduled[g] = 0;
+  numScheduled--;
+  return g;
+}
+
+/** \brief Returns true if no gates are scheduled. */
+bool LevelQueue::empty() const { return numScheduled == 0; }
+
+/** \brief Remove all scheduled gates. */
+void LevelQueue::clear() {
+  int g;
+  while ((g = pop()) != -1)
+    ;
+}
@@ -0,0 +1,39 @@
+#ifndef CLASSLEVELQUEUE_H
+#define CLASSLEVELQUEUE_H
+
+#include "ClassCircuit.h"
+#include <vector>    // vector
+#include <stdint.h>  // uint32_t
+using namespace std;
+
+class LevelQueue{
+
+ private:
+  const Circuit* circuit;            // The circuit whose gate levels are used
+  vector< vector<uint32_t> > bucket; // bucket[l] holds the scheduled gates at level l
+  vector<char> scheduled;            // scheduled[g] is 1 if gate g is in a bucket
+  int currentLevel;                  // No bucket below this level holds a gate
+  int numScheduled;                  // Total number of gates in all buckets
+
+ public:
+  LevelQueue();
+  void init(const Circuit* c);
+
+  /** \brief Schedule gate \a g for evaluation (does nothing if it is already scheduled). */
+  inline void push(int g) {
+    if (scheduled[g])
+      return;
+    scheduled[g] = 1;
+    int l = circuit->getLevel(g);
+    bucket[l].push_back(g);
+    if (l < currentLevel)
+      currentLevel = l;
+    numScheduled++;
+  }
+  void pushFanouts(int g);
+  int pop();
+  bool empty() const;
+  void clear();
+};
+
+#endif
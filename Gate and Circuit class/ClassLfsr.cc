@@ -0,0 +1,25 @@
+/** \class Lfsr
+ * \brief A 64-bit maximal-length linear feedback shift register, used as a pseudo-random pattern generator.
+ *
+ * The sequence depends only on the seed, so random test patterns are the same from run to run.
+ */
+
+#include "ClassLfsr.h"
+
+/** \brief Construct an LFSR.
+ *  \param seed The initial state (0 is replaced by 1, since an all-zero LFSR never leaves 0)
+ */
+Lfsr::Lfsr(uint64_t seed) {
+  state = (seed == 0) ? 1 : seed;
+}
+
+/** \brief Clock the LFSR 64 times and return the output bits, the first one in bit 0.
+ *
+ * This gives one PI's values in 64 patterns, packed as for ParallelSim.
+ */
+uint64_t Lfsr::nextWord() {
+  uint64_t w = 0;
+  for (int k=0; k<64; k++)
+    w |= (uint64_t)nextBit() << k;
+  return w;
+}
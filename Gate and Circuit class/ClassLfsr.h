@@ -0,0 +1,28 @@
+#ifndef CLASSLFSR_H
+#define CLASSLFSR_H
+
+#include <stdint.h>  // uint64_t
+
+// Feedback taps of the 64-bit Galois LFSR: x^64 + x^63 + x^61 + x^60 + 1 (maximal length)
+#define LFSR_TAPS 0xD800000000000000ULL
+
+class Lfsr{
+
+ private:
+  uint64_t state;   // The register (never 0)
+
+ public:
+  Lfsr(uint64_t seed);
+
+  /** \brief Clock the LFSR once and return its output bit. */
+  inline int nextBit() {
+    int out = state & 1;
+    state >>= 1;
+    if (out)
+      state ^= LFSR_TAPS;
+    return out;
+  }
+  uint64_t nextWord();
+};
+
+#endif
@@ -0,0 +1,16 @@
+/** \class LogicKernel
+ * \brief Table-driven evaluation of gates in the 5-valued D-calculus (0, 1, D, D', X).
+ *
+ * All tables are computed at compile time from three-valued AND, OR and XOR applied to the
+ * good and faulty circuits separately (see kernelFold()). Gate evaluation reads the fanin
+ * values straight from the gate value array, with no copies or allocation, and the gate type
+ * is a template parameter (see eval()), so each input costs one table lookup.
+ */
+
+#include "ClassLogicKernel.h"
+
+constexpr char LogicKernel::pairTable[3][5][5];
+constexpr char LogicKernel::foldTable[3][KERNEL_STATES][5];
+constexpr char LogicKernel::foldStart[3];
+constexpr char LogicKernel::stateValue[KERNEL_STATES];
+constexpr char LogicKernel::notTable[5];
@@ -0,0 +1,128 @@
+#ifndef CLASSLOGICKERNEL_H
+#define CLASSLOGICKERNEL_H
+
+#include "ClassGate.h"
+#include <stdint.h>  // uint32_t
+
+// The three gate functions the tables are built for (a gate is one of these, possibly inverted)
+#define KERNEL_AND 0
+#define KERNEL_OR  1
+#define KERNEL_XOR 2
+
+// While folding across the fanin, the value so far is a pair of three-valued values (0, 1, X=2),
+// one for the good and one for the faulty circuit, stored as 3*good + faulty. (The 5 values
+// are not enough: X AND D is not X, since AND-ing it with D' gives 0.)
+#define KERNEL_STATES 9
+
+/** \brief Good-circuit value (0, 1 or 2 for X) of a 5-valued LOGIC_* value. */
+constexpr int kernelGood(int v) { return (v == LOGIC_ONE || v == LOGIC_D) ? 1 : (v == LOGIC_X) ? 2 : 0; }
+/** \brief Faulty-circuit value (0, 1 or 2 for X) of a 5-valued LOGIC_* value. */
+constexpr int kernelFaulty(int v) { return (v == LOGIC_ONE || v == LOGIC_DBAR) ? 1 : (v == LOGIC_X) ? 2 : 0; }
+/** \brief The fold state of a 5-valued value. */
+constexpr int kernelState(int v) { return 3*kernelGood(v) + kernelFaulty(v); }
+/** \brief The 5-valued value of a fold state. */
+constexpr char kernelValue(int s) {
+  return (s == 0) ? LOGIC_ZERO : (s == 4) ? LOGIC_ONE : (s == 3) ? LOGIC_D : (s == 1) ? LOGIC_DBAR : LOGIC_X;
+}
+/** \brief Three-valued AND, OR, XOR of a and b (0, 1 or 2 for X). */
+constexpr int kernelOp3(int op, int a, int b) {
+  return (op == KERNEL_AND) ? ((a == 0 || b == 0) ? 0 : (a == 2 || b == 2) ? 2 : 1)
+       : (op == KERNEL_OR)  ? ((a == 1 || b == 1) ? 1 : (a == 2 || b == 2) ? 2 : 0)
+       :                      ((a == 2 || b == 2) ? 2 : (a ^ b));
+}
+/** \brief Fold the 5-valued value \a v into state \a s. */
+constexpr int kernelFold(int op, int s, int v) {
+  return 3*kernelOp3(op, s/3, kernelGood(v)) + kernelOp3(op, s%3, kernelFaulty(v));
+}
+/** \brief 5-valued result of a 2-input gate. */
+constexpr char kernelPair(int op, int a, int b) { return kernelValue(kernelFold(op, kernelState(a), b)); }
+
+#define KERNEL_ROW(f, op, a) { f(op, a, 0), f(op, a, 1), f(op, a, 2), f(op, a, 3), f(op, a, 4) }
+#define KERNEL_PAIRS(op) { KERNEL_ROW(kernelPair, op, 0), KERNEL_ROW(kernelPair, op, 1), KERNEL_ROW(kernelPair, op, 2), \
+    KERNEL_ROW(kernelPair, op, 3), KERNEL_ROW(kernelPair, op, 4) }
+#define KERNEL_FOLDS(op) { KERNEL_ROW(kernelFold, op, 0), KERNEL_ROW(kernelFold, op, 1), KERNEL_ROW(kernelFold, op, 2), \
+    KERNEL_ROW(kernelFold, op, 3), KERNEL_ROW(kernelFold, op, 4), KERNEL_ROW(kernelFold, op, 5), \
+    KERNEL_ROW(kernelFold, op, 6), KERNEL_ROW(kernelFold, op, 7), KERNEL_ROW(kernelFold, op, 8) }
+
+class LogicKernel{
+
+ public:
+  // 5x5 truth tables of the 2-input AND, OR and XOR, indexed [op][a][b] by LOGIC_* values
+  static constexpr char pairTable[3][5][5] = { KERNEL_PAIRS(KERNEL_AND), KERNEL_PAIRS(KERNEL_OR), KERNEL_PAIRS(KERNEL_XOR) };
+  // Fold tables for wider gates: the state after combining state s with value v is foldTable[op][s][v]
+  static constexpr char foldTable[3][KERNEL_STATES][5] = { KERNEL_FOLDS(KERNEL_AND), KERNEL_FOLDS(KERNEL_OR), KERNEL_FOLDS(KERNEL_XOR) };
+  // The state to start a fold from (1 for AND, 0 for OR and XOR, in both circuits)
+  static constexpr char foldStart[3] = { kernelState(LOGIC_ONE), kernelState(LOGIC_ZERO), kernelState(LOGIC_ZERO) };
+  // The 5-valued value of each fold state
+  static constexpr char stateValue[KERNEL_STATES] = { kernelValue(0), kernelValue(1), kernelValue(2), kernelValue(3),
+    kernelValue(4), kernelValue(5), kernelValue(6), kernelValue(7), kernelValue(8) };
+  // NOT of each LOGIC_* value
+  static constexpr char notTable[5] = { LOGIC_ONE, LOGIC_ZERO, LOGIC_DBAR, LOGIC_D, LOGIC_X };
+
+  /** \brief 5-valued NOT (\a v must be one of the LOGIC_* values, not LOGIC_UNSET). */
+  static inline char logicNot(char v) { return notTable[(int)v]; }
+
+  template <int gateType>
+  static inline char eval(const char* values, const uint32_t* fanin, int n);
+
+  static inline char evalGate(char gateType, const char* values, const uint32_t* fanin, int n);
+};
+
+/** \brief For each gate type: which table it uses, and whether its output is inverted. */
+template <int gateType> struct GateKernel;
+template <> struct GateKernel<GATE_AND>  { enum { op = KERNEL_AND, invert = 0 }; };
+template <> struct GateKernel<GATE_NAND> { enum { op = KERNEL_AND, invert = 1 }; };
+template <> struct GateKernel<GATE_OR>   { enum { op = KERNEL_OR,  invert = 0 }; };
+template <> struct GateKernel<GATE_NOR>  { enum { op = KERNEL_OR,  invert = 1 }; };
+template <> struct GateKernel<GATE_XOR>  { enum { op = KERNEL_XOR, invert = 0 }; };
+template <> struct GateKernel<GATE_XNOR> { enum { op = KERNEL_XOR, invert = 1 }; };
+
+/** \brief Evaluate a gate of type \a gateType from the values of its fanins.
+ *  \param values The LOGIC_* value of every gate
+ *  \param fanin The gate's fanin indices (see Circuit::getFanin())
+ *  \param n The number of fanins
+ *  \returns The gate's output value (not including a possible fault on it)
+ *
+ * A 2-input gate is one lookup; wider gates fold their inputs one lookup at a time.
+ */
+template <int gateType>
+inline char LogicKernel::eval(const char* values, const uint32_t* fanin, int n) {
+  const int op = GateKernel<gateType>::op;
+  char out;
+  if (n == 2)
+    out = pairTable[op][(int)values[fanin[0]]][(int)values[fanin[1]]];
+  else {
+    int s = foldStart[op];
+    for (int i=0; i<n; i++)
+      s = foldTable[op][s][(int)values[fanin[i]]];
+    out = stateValue[s];
+  }
+  return GateKernel<gateType>::invert ? notTable[(int)out] : out;
+}
+
+template <>
+inline char LogicKernel::eval<GATE_BUFF>(const char* values, const uint32_t* fanin, int /*n*/) { return values[fanin[0]]; }
+
+template <>
+inline char LogicKernel::eval<GATE_FANOUT>(const char* values, const uint32_t* fanin, int /*n*/) { return values[fanin[0]]; }
+
+template <>
+inline char LogicKernel::eval<GATE_NOT>(const char* values, const uint32_t* fanin, int /*n*/) { return notTable[(int)values[fanin[0]]]; }
+
+/** \brief Evaluate a gate given its type at run time (see eval()). PIs are not evaluated. */
+inline char LogicKernel::evalGate(char gateType, const char* values, const uint32_t* fanin, int n) {
+  switch (gateType) {
+  case GATE_NAND: return eval<GATE_NAND>(values, fanin, n);
+  case GATE_NOR: return eval<GATE_NOR>(values, fanin, n);
+  case GATE_AND: return eval<GATE_AND>(values, fanin, n);
+  case GATE_OR: return eval<GATE_OR>(values, fanin, n);
+  case GATE_XOR: return eval<GATE_XOR>(values, fanin, n);
+  case GATE_XNOR: return eval<GATE_XNOR>(values, fanin, n);
+  case GATE_BUFF: return eval<GATE_BUFF>(values, fanin, n);
+  case GATE_NOT: return eval<GATE_NOT>(values, fanin, n);
+  case GATE_FANOUT: return eval<GATE_FANOUT>(values, fanin, n);
+  }
+  return LOGIC_X;
+}
+
+#endif
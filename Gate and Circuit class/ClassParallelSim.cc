@@ -0,0 +1,67 @@
+/** \class ParallelSim
+ * \brief A bit-parallel good-machine (fault-free) logic simulator.
+ *
+ * Each signal carries a 64-bit word, and bit \a k of every word belongs to pattern \a k, so one
+ * pass over the circuit simulates 64 input patterns at once. Values are two-valued (0/1):
+ * patterns must be fully specified (X-filled) before they are loaded. Each gate type is
+ * evaluated with plain bitwise operations, in the levelized order from Circuit::getLevelOrder().
+ *
+ * Typical use: load one word per PI with \a setPIWord() (or all of them with \a setPIWords()),
+ * call \a simulate(), then read one word per PO with \a getPOWord().
+ */
+
+#include "ClassParallelSim.h"
+
+/** \brief Construct a simulator for a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+ParallelSim::ParallelSim(const Circuit* c) {
+  circuit = c;
+  values.assign(c->getLevelOrder().size(), 0);
+}
+
+/** \brief Load the packed values of one PI.
+ *  \param i The PI number (position in Circuit::getPIIndices())
+ *  \param w Bit \a k is the value of this PI in pattern \a k
+ */
+void ParallelSim::setPIWord(int i, uint64_t w) {
+  values[circuit->getPIIndices()[i]] = w;
+}
+
+/** \brief Load the packed values of all PIs.
+ *  \param w One word per PI, in the order of Circuit::getPIIndices()
+ */
+void ParallelSim::setPIWords(const vector<uint64_t>& w) {
+  const vector<uint32_t>& pis = circuit->getPIIndices();
+  if (w.size() != pis.size()) {
+    cout << "ERROR: Incorrect number of input words: " << w.size() << " vs " << pis.size() << endl;
+    assert(false);
+  }
+  for (int i=0; i<pis.size(); i++)
+    values[pis[i]] = w[i];
+}
+
+/** \brief Simulate all 64 patterns through the circuit, in level order. */
+void ParallelSim::simulate() {
+  const vector<uint32_t>& order = circuit->getLevelOrder();
+  uint64_t* vals = &values[0];
+  for (int k=0; k<order.size(); k++)
+    vals[order[k]] = evalGate(circuit, order[k], vals);
+}
+
+/** \brief Get the packed values of one PO after simulate().
+ *  \param i The PO number (position in Circuit::getPOIndices())
+ *  \return Bit \a k is the value of this PO in pattern \a k
+ */
+uint64_t ParallelSim::getPOWord(int i) const {
+  return values[circuit->getPOIndices()[i]];
+}
+
+/** \brief Get the packed values of all POs after simulate(), in the order of Circuit::getPOIndices(). */
+vector<uint64_t> ParallelSim::getPOWords() const {
+  const vector<uint32_t>& pos = circuit->getPOIndices();
+  vector<uint64_t> w(pos.size());
+  for (int i=0; i<pos.size(); i++)
+    w[i] = values[pos[i]];
+  return w;
+}
@@ -0,0 +1,71 @@
+#ifndef CLASSPARALLELSIM_H
+#define CLASSPARALLELSIM_H
+
+#include "ClassCircuit.h"
+#include <vector>    // vector
+#include <stdint.h>  // uint64_t
+using namespace std;
+
+// Number of patterns simulated at once (one per bit of a word)
+#define PATTERNS_PER_WORD 64
+
+class ParallelSim{
+
+ private:
+  const Circuit* circuit;   // The circuit being simulated
+  vector<uint64_t> values;  // Packed good-machine value of each gate's output (bit k: pattern k)
+
+ public:
+  ParallelSim(const Circuit* c);
+
+  void setPIWord(int i, uint64_t w);
+  void setPIWords(const vector<uint64_t>& w);
+  void simulate();
+  uint64_t getPOWord(int i) const;
+  vector<uint64_t> getPOWords() const;
+
+  /** \brief Get the packed value of gate \a g after simulate(). */
+  inline uint64_t getWord(int g) const { return values[g]; }
+
+  /** \brief Get the packed values of all gates after simulate(), indexed by gate. */
+  inline const vector<uint64_t>& getWords() const { return values; }
+
+  /** \brief Evaluate gate \a g from the packed values of its fanins in \a vals.
+   *  \param c The circuit
+   *  \param g The gate index
+   *  \param vals The packed value of every gate (indexed by gate)
+   *  \return The packed value of the output of \a g
+   */
+  static inline uint64_t evalGate(const Circuit* c, int g, const uint64_t* vals) {
+    const uint32_t* in = c->getFanin(g);
+    int n = c->getFaninCount(g);
+    uint64_t r;
+    switch (c->getGateType(g)) {
+    case GATE_AND:
+    case GATE_NAND:
+      r = vals[in[0]];
+      for (int j=1; j<n; j++) r &= vals[in[j]];
+      return (c->getGateType(g) == GATE_NAND) ? ~r : r;
+    case GATE_OR:
+    case GATE_NOR:
+      r = vals[in[0]];
+      for (int j=1; j<n; j++) r |= vals[in[j]];
+      return (c->getGateType(g) == GATE_NOR) ? ~r : r;
+    case GATE_XOR:
+    case GATE_XNOR:
+      r = vals[in[0]];
+      for (int j=1; j<n; j++) r ^= vals[in[j]];
+      return (c->getGateType(g) == GATE_XNOR) ? ~r : r;
+    case GATE_BUFF:
+    case GATE_FANOUT:
+      return vals[in[0]];
+    case GATE_NOT:
+      return ~vals[in[0]];
+    default:
+      // PIs keep the value they were given
+      return vals[g];
+    }
+  }
+};
+
+#endif
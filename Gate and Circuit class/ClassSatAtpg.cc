@@ -0,0 +1,205 @@
+/** \class SatAtpg
+ * \brief SAT-based test generation for single stuck-at faults.
+ *
+ * For a fault on gate g, \a generateTest() builds a miter: a CNF copy of the fault-free circuit
+ * (only the gates that g's fanout cone depends on), a second copy of the cone with g stuck at
+ * the fault value, and a clause saying some PO in the cone differs between the two. The
+ * gates are encoded with the Tseitin transformation. Any model is a test, and if the formula
+ * is unsatisfiable the fault is untestable. The formula is solved by SatSolver.
+ *
+ * Like AtpgEngine, a SatAtpg only reads the circuit, so each thread can have its own.
+ */
+
+#include "ClassSatAtpg.h"
+
+/** \brief Construct a SAT test generator for a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+SatAtpg::SatAtpg(const Circuit* c) {
+  circuit = c;
+  int n = c->getLevelOrder().size();
+  goodVar.assign(n, -1);
+  faultyVar.assign(n, -1);
+  conflictLimit = -1;
+  numConflicts = 0;
+  stopFlag = NULL;
+}
+
+/** \brief Set the number of solver conflicts allowed per fault (-1: no limit). */
+void SatAtpg::setConflictLimit(long n) { conflictLimit = n; }
+
+/** \brief Cancel generateTest() (it returns SAT_UNKNOWN) once \a *stop is true (NULL: never). */
+void SatAtpg::setStopFlag(const atomic<bool>* stop) { stopFlag = stop; }
+
+/** \brief Get the number of solver conflicts for the last fault. */
+long SatAtpg::getNumConflicts() const { return numConflicts; }
+
+/** \brief Generate a test for one stuck-at fault.
+ *  \param g The gate whose output is faulty
+ *  \param type FAULT_SA0 or FAULT_SA1
+ *  \returns SAT_SAT (a test was found, see getTest()), SAT_UNSAT (the fault is untestable), or
+ *  SAT_UNKNOWN (the conflict limit was reached, or the search was cancelled).
+ */
+int SatAtpg::generateTest(int g, char type) {
+  SatSolver solver;
+  solver.setStopFlag(stopFlag);
+
+  // the fanout cone of g, and the POs in it
+  cone.clear();
+  faultyVar[g] = solver.newVar();
+  cone.push_back(g);
+  vector<int> conePOs;
+  for (int i=0; i<cone.size(); i++) {
+    int h = cone[i];
+    if (circuit->isPOGate(h))
+      conePOs.push_back(h);
+    const uint32_t* succ = circuit->getFanout(h);
+    for (int j=0; j<circuit->getFanoutCount(h); j++) {
+      if (faultyVar[succ[j]] == -1) {
+        faultyVar[succ[j]] = solver.newVar();
+        cone.push_back(succ[j]);
+      }
+    }
+  }
+
+  // everything the cone depends on
+  support.clear();
+  for (int i=0; i<cone.size(); i++) {
+    goodVar[cone[i]] = solver.newVar();
+    support.push_back(cone[i]);
+  }
+  for (int i=0; i<support.size(); i++) {
+    int h = support[i];
+    const uint32_t* pred = circuit->getFanin(h);
+    for (int j=0; j<circuit->getFaninCount(h); j++) {
+      if (goodVar[pred[j]] == -1) {
+        goodVar[pred[j]] = solver.newVar();
+        support.push_back(pred[j]);
+      }
+    }
+  }
+
+  // the fault-free circuit
+  for (int i=0; i<support.size(); i++)
+    addGateClauses(solver, support[i], false);
+
+  // the faulty cone (g itself is just stuck)
+  for (int i=1; i<cone.size(); i++)
+    addGateClauses(solver, cone[i], true);
+
+  // g is stuck, and is activated in the fault-free circuit
+  bool stuckAt1 = (type == FAULT_SA1);
+  solver.addClause(vector<int>(1, satLit(faultyVar[g], !stuckAt1)));
+  solver.addClause(vector<int>(1, satLit(goodVar[g], stuckAt1)));
+
+  // some PO differs
+  vector<int> anyDiff;
+  for (int i=0; i<conePOs.size(); i++) {
+    int o = conePOs[i];
+    int d = solver.newVar();
+    vector<int> c(3);
+    c[0] = satLit(d, true); c[1] = satLit(goodVar[o], false); c[2] = satLit(faultyVar[o], false);
+    solver.addClause(c);
+    c[1] = satLit(goodVar[o], true); c[2] = satLit(faultyVar[o], true);
+    solver.addClause(c);
+    anyDiff.push_back(satLit(d, false));
+  }
+  solver.addClause(anyDiff);
+
+  int res = solver.solve(conflictLimit);
+  numConflicts = solver.getNumConflicts();
+
+  const vector<uint32_t>& pis = circuit->getPIIndices();
+  test.assign(pis.size(), LOGIC_X);
+  if (res == SAT_SAT)
+    for (int i=0; i<pis.size(); i++)
+      if (goodVar[pis[i]] != -1)
+        test[i] = solver.getValue(goodVar[pis[i]]) ? LOGIC_ONE : LOGIC_ZERO;
+
+  for (int i=0; i<support.size(); i++)
+    goodVar[support[i]] = -1;
+  for (int i=0; i<cone.size(); i++)
+    faultyVar[cone[i]] = -1;
+  return res;
+}
+
+/** \brief Add the Tseitin clauses of gate \a g.
+ *  \param solver The solver to add them to
+ *  \param g The gate
+ *  \param faulty If true, encode g in the faulty circuit (g must be in the fault's cone;
+ *  its inputs from outside the cone have their fault-free values)
+ */
+void SatAtpg::addGateClauses(SatSolver &solver, int g, bool faulty) {
+  const uint32_t* pred = circuit->getFanin(g);
+  int n = circuit->getFaninCount(g);
+  char type = circuit->getGateType(g);
+  int out = faulty ? faultyVar[g] : goodVar[g];
+  vector<int> in(n);
+  for (int i=0; i<n; i++)
+    in[i] = (faulty && (faultyVar[pred[i]] != -1)) ? faultyVar[pred[i]] : goodVar[pred[i]];
+  vector<int> c;
+
+  switch (type) {
+  case GATE_PI:
+    return;
+
+  case GATE_BUFF:
+  case GATE_FANOUT:
+  case GATE_NOT: {
+    bool inv = (type == GATE_NOT);
+    c.resize(2);
+    c[0] = satLit(out, true); c[1] = satLit(in[0], inv);
+    solver.addClause(c);
+    c[0] = satLit(out, false); c[1] = satLit(in[0], !inv);
+    solver.addClause(c);
+    return;
+  }
+
+  case GATE_AND:
+  case GATE_NAND:
+  case GATE_OR:
+  case GATE_NOR: {
+    // with o the output before inversion: AND is o = a & b & ..., and OR is its dual
+    bool isOr = (type == GATE_OR) || (type == GATE_NOR);
+    bool inv = (type == GATE_NAND) || (type == GATE_NOR);
+    int o = satLit(out, inv);
+    c.resize(2);
+    for (int i=0; i<n; i++) {
+      c[0] = o ^ 1 ^ isOr; c[1] = satLit(in[i], isOr);
+      solver.addClause(c);
+    }
+    c.clear();
+    c.push_back(o ^ isOr);
+    for (int i=0; i<n; i++)
+      c.push_back(satLit(in[i], !isOr));
+    solver.addClause(c);
+    return;
+  }
+
+  case GATE_XOR:
+  case GATE_XNOR: {
+    // a chain of 2-input XORs, with an extra variable per link
+    int acc = satLit(in[0], false);
+    for (int i=1; i<n; i++) {
+      int b = satLit(in[i], false);
+      int t = (i == n-1) ? satLit(out, type == GATE_XNOR) : satLit(solver.newVar(), false);
+      c.resize(3);
+      c[0] = t ^ 1; c[1] = acc;     c[2] = b;     solver.addClause(c);
+      c[0] = t ^ 1; c[1] = acc ^ 1; c[2] = b ^ 1; solver.addClause(c);
+      c[0] = t;     c[1] = acc ^ 1; c[2] = b;     solver.addClause(c);
+      c[0] = t;     c[1] = acc;     c[2] = b ^ 1; solver.addClause(c);
+      acc = t;
+    }
+    if (n == 1) {
+      c.resize(2);
+      c[0] = satLit(out, true);  c[1] = acc ^ (type == GATE_XNOR); solver.addClause(c);
+      c[0] = satLit(out, false); c[1] = acc ^ 1 ^ (type == GATE_XNOR); solver.addClause(c);
+    }
+    return;
+  }
+
+  default:
+    cout << "ERROR: Do not know how to encode gate type " << (int)type << endl;
+    assert(false);
+  }
+}
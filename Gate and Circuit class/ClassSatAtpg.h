@@ -0,0 +1,37 @@
+#ifndef CLASSSATATPG_H
+#define CLASSSATATPG_H
+
+#include "ClassCircuit.h"
+#include "ClassSatSolver.h"
+#include <vector>    // vector
+using namespace std;
+
+class SatAtpg{
+
+ private:
+  const Circuit* circuit;     // The circuit (shared, never modified)
+  long conflictLimit;         // Conflicts allowed per fault (-1: no limit)
+  long numConflicts;          // Conflicts the solver needed for the last fault
+  const atomic<bool>* stopFlag; // Passed on to the solver (see SatSolver::setStopFlag())
+
+  vector<int> goodVar;        // Variable of each gate in the fault-free circuit, or -1
+  vector<int> faultyVar;      // Variable of each gate in the faulty circuit, or -1 outside the fault's cone
+  vector<int> cone;           // The fault's fanout cone
+  vector<int> support;        // The gates the cone depends on (the cone and its transitive fanin)
+  vector<char> test;          // The last test: one LOGIC_ZERO, LOGIC_ONE or LOGIC_X per PI
+
+  void addGateClauses(SatSolver &solver, int g, bool faulty);
+
+ public:
+  SatAtpg(const Circuit* c);
+
+  void setConflictLimit(long n);
+  void setStopFlag(const atomic<bool>* stop);
+  int generateTest(int g, char type);
+
+  /** \brief After generateTest() returns SAT_SAT, the test: one value per PI (LOGIC_X if it does not matter). */
+  inline const vector<char>& getTest() const { return test; }
+  long getNumConflicts() const;
+};
+
+#endif
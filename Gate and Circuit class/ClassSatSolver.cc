@@ -0,0 +1,403 @@
+/** \class SatSolver
+ * \brief A small CDCL SAT solver.
+ *
+ * Literals are ints: 2*v for variable v and 2*v+1 for its negation (see satLit()). The solver
+ * is the usual conflict-driven design:
+ *   - two watched literals per clause (the first two), so propagation only visits the clauses
+ *     watching a literal that has just become false;
+ *   - VSIDS decisions: variables in a learnt clause's derivation are bumped, all activities
+ *     decay geometrically, and the most active unassigned variable is branched on, with its
+ *     last value (phase saving);
+ *   - first-UIP clause learning with non-chronological backtracking, plus a cheap
+ *     minimization that drops literals implied by the rest of the learnt clause;
+ *   - restarts on the Luby sequence (SAT_RESTART_BASE conflicts per unit).
+ *
+ * It is meant for the small, structured formulas of ATPG (see SatAtpg), so learnt clauses are
+ * kept for the whole call; the conflict limit given to solve() bounds their number.
+ */
+
+#include "ClassSatSolver.h"
+
+/** \brief The i'th element (from 0) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ... */
+static long luby(int i) {
+  long size = 1;
+  int seq = 0;
+  while (size < i+1) {
+    seq++;
+    size = 2*size + 1;
+  }
+  while (size-1 != i) {
+    size = (size-1) >> 1;
+    seq--;
+    i = i % size;
+  }
+  return 1L << seq;
+}
+
+/** \brief Construct a solver with no variables and no clauses. */
+SatSolver::SatSolver() {
+  numVars = 0;
+  ok = true;
+  qhead = 0;
+  varInc = 1;
+  numConflicts = 0;
+  numDecisions = 0;
+  stopFlag = NULL;
+}
+
+/** \brief Make solve() give up (return SAT_UNKNOWN) as soon as \a *stop becomes true.
+ *  Another thread can set it to cancel the search. NULL: never stop.
+ */
+void SatSolver::setStopFlag(const atomic<bool>* stop) { stopFlag = stop; }
+
+/** \brief Add a variable, and return its number. */
+int SatSolver::newVar() {
+  int v = numVars++;
+  watches.resize(2*numVars);
+  assigns.push_back(-1);
+  level.push_back(0);
+  reason.push_back(-1);
+  activity.push_back(0);
+  heapPos.push_back(-1);
+  polarity.push_back(0);
+  seen.push_back(0);
+  heapInsert(v);
+  return v;
+}
+
+/** \brief Get the number of variables. */
+int SatSolver::getNumberVars() const { return numVars; }
+
+/** \brief Get the number of conflicts over all calls to solve(). */
+long SatSolver::getNumConflicts() const { return numConflicts; }
+
+/** \brief Get the number of decisions over all calls to solve(). */
+long SatSolver::getNumDecisions() const { return numDecisions; }
+
+/** \brief Add a clause (before solve()).
+ *  \returns false if the clauses are now known to be unsatisfiable.
+ */
+bool SatSolver::addClause(vector<int> lits) {
+  if (!ok)
+    return false;
+
+  // drop false and repeated literals; a true literal or a tautology satisfies the clause
+  int j = 0;
+  for (int i=0; i<lits.size(); i++) {
+    int l = lits[i];
+    if (value(l) == 1)
+      return true;
+    if (value(l) == 0)
+      continue;
+    bool dup = false;
+    for (int k=0; k<j; k++) {
+      if (lits[k] == (l ^ 1))
+        return true;
+      if (lits[k] == l)
+        dup = true;
+    }
+    if (!dup)
+      lits[j++] = l;
+  }
+  lits.resize(j);
+
+  if (lits.empty()) {
+    ok = false;
+    return false;
+  }
+  if (lits.size() == 1) {
+    enqueue(lits[0], -1);
+    if (propagate() != -1)
+      ok = false;
+    return ok;
+  }
+
+  int ci = clauses.size();
+  clauses.push_back(lits);
+  watches[lits[0]].push_back(ci);
+  watches[lits[1]].push_back(ci);
+  return true;
+}
+
+/** \brief Make literal \a l true, implied by clause \a from (-1 for a decision or unit). */
+void SatSolver::enqueue(int l, int from) {
+  int v = l >> 1;
+  assigns[v] = (l & 1) ^ 1;
+  level[v] = decisionLevel();
+  reason[v] = from;
+  trail.push_back(l);
+}
+
+/** \brief Propagate the assignments on the trail.
+ *  \returns The index of a clause with every literal false, or -1 if there is no conflict.
+ */
+int SatSolver::propagate() {
+  while (qhead < trail.size()) {
+    int falseLit = trail[qhead++] ^ 1;
+    vector<int> &ws = watches[falseLit];
+    int i = 0, j = 0;
+    while (i < ws.size()) {
+      int ci = ws[i++];
+      vector<int> &c = clauses[ci];
+
+      // make c[1] the literal that just became false
+      if (c[0] == falseLit) {
+        c[0] = c[1];
+        c[1] = falseLit;
+      }
+      if (value(c[0]) == 1) {
+        ws[j++] = ci;
+        continue;
+      }
+
+      // look for another literal to watch
+      int k;
+      for (k=2; k<c.size(); k++)
+        if (value(c[k]) != 0)
+          break;
+      if (k < c.size()) {
+        c[1] = c[k];
+        c[k] = falseLit;
+        watches[c[1]].push_back(ci);
+        continue;
+      }
+
+      // the clause is unit or false
+      ws[j++] = ci;
+      if (value(c[0]) == 0) {
+        while (i < ws.size())
+          ws[j++] = ws[i++];
+        ws.resize(j);
+        qhead = trail.size();
+        return ci;
+      }
+      enqueue(c[0], ci);
+    }
+    ws.resize(j);
+  }
+  return -1;
+}
+
+/** \brief First-UIP conflict analysis.
+ *  \param confl The false clause
+ *  \param learnt Output: the learnt clause; learnt[0] is the UIP (negated) and learnt[1], if
+ *  any, has the highest level of the others
+ *  \param btLevel Output: the level to backtrack to
+ */
+void SatSolver::analyze(int confl, vector<int> &learnt, int &btLevel) {
+  learnt.clear();
+  learnt.push_back(-1);
+  int pathCount = 0;
+  int p = -1;
+  int idx = trail.size() - 1;
+
+  do {
+    const vector<int> &c = clauses[confl];
+    for (int k=(p == -1) ? 0 : 1; k<c.size(); k++) {
+      int v = c[k] >> 1;
+      if (!seen[v] && (level[v] > 0)) {
+        bumpVar(v);
+        seen[v] = 1;
+        if (level[v] >= decisionLevel())
+          pathCount++;
+        else
+          learnt.push_back(c[k]);
+      }
+    }
+    // the next literal of the current level to expand
+    while (!seen[trail[idx] >> 1])
+      idx--;
+    p = trail[idx--];
+    confl = reason[p >> 1];
+    seen[p >> 1] = 0;
+    pathCount--;
+  } while (pathCount > 0);
+  learnt[0] = p ^ 1;
+
+  // drop literals implied by the others, then clear the flags
+  vector<int> all(learnt);
+  int j = 1;
+  for (int i=1; i<learnt.size(); i++)
+    if (!redundant(learnt[i]))
+      learnt[j++] = learnt[i];
+  learnt.resize(j);
+  for (int i=1; i<all.size(); i++)
+    seen[all[i] >> 1] = 0;
+
+  btLevel = 0;
+  for (int i=1; i<learnt.size(); i++) {
+    if (level[learnt[i] >> 1] > btLevel) {
+      btLevel = level[learnt[i] >> 1];
+      int t = learnt[1];
+      learnt[1] = learnt[i];
+      learnt[i] = t;
+    }
+  }
+}
+
+/** \brief Returns true if literal \a l of a learnt clause is implied by the other literals
+ *  (its reason only has literals that are in the clause or assigned at level 0). */
+bool SatSolver::redundant(int l) const {
+  int r = reason[l >> 1];
+  if (r == -1)
+    return false;
+  const vector<int> &c = clauses[r];
+  for (int k=1; k<c.size(); k++) {
+    int v = c[k] >> 1;
+    if (!seen[v] && (level[v] > 0))
+      return false;
+  }
+  return true;
+}
+
+/** \brief Undo all assignments above decision level \a lvl. */
+void SatSolver::backtrack(int lvl) {
+  if (decisionLevel() <= lvl)
+    return;
+  for (int i=trail.size()-1; i>=trailLim[lvl]; i--) {
+    int v = trail[i] >> 1;
+    polarity[v] = assigns[v];
+    assigns[v] = -1;
+    reason[v] = -1;
+    heapInsert(v);
+  }
+  trail.resize(trailLim[lvl]);
+  trailLim.resize(lvl);
+  qhead = trail.size();
+}
+
+/** \brief Pick the next decision: the most active unassigned variable, at its saved phase.
+ *  \returns The literal, or -1 if every variable is assigned.
+ */
+int SatSolver::pickBranchLit() {
+  while (!heap.empty()) {
+    int v = heapPop();
+    if (assigns[v] < 0)
+      return satLit(v, !polarity[v]);
+  }
+  return -1;
+}
+
+/** \brief Bump the activity of variable \a v. */
+void SatSolver::bumpVar(int v) {
+  activity[v] += varInc;
+  if (activity[v] > 1e100) {
+    for (int i=0; i<numVars; i++)
+      activity[i] *= 1e-100;
+    varInc *= 1e-100;
+  }
+  if (heapPos[v] >= 0)
+    heapUp(heapPos[v]);
+}
+
+void SatSolver::heapUp(int i) {
+  int v = heap[i];
+  while ((i > 0) && (activity[heap[(i-1)/2]] < activity[v])) {
+    heap[i] = heap[(i-1)/2];
+    heapPos[heap[i]] = i;
+    i = (i-1)/2;
+  }
+  heap[i] = v;
+  heapPos[v] = i;
+}
+
+void SatSolver::heapDown(int i) {
+  int v = heap[i];
+  int n = heap.size();
+  while (2*i+1 < n) {
+    int child = 2*i+1;
+    if ((child+1 < n) && (activity[heap[child+1]] > activity[heap[child]]))
+      child++;
+    if (activity[heap[child]] <= activity[v])
+      break;
+    heap[i] = heap[child];
+    heapPos[heap[i]] = i;
+    i = child;
+  }
+  heap[i] = v;
+  heapPos[v] = i;
+}
+
+void SatSolver::heapInsert(int v) {
+  if (heapPos[v] >= 0)
+    return;
+  heap.push_back(v);
+  heapUp(heap.size()-1);
+}
+
+int SatSolver::heapPop() {
+  int v = heap[0];
+  heapPos[v] = -1;
+  int last = heap.back();
+  heap.pop_back();
+  if (!heap.empty()) {
+    heap[0] = last;
+    heapPos[last] = 0;
+    heapDown(0);
+  }
+  return v;
+}
+
+/** \brief Solve the clauses.
+ *  \param conflictLimit The number of conflicts allowed (-1: no limit)
+ *  \returns SAT_SAT (read the model with getValue()), SAT_UNSAT, or SAT_UNKNOWN if the
+ *  limit was reached or the stop flag was set.
+ */
+int SatSolver::solve(long conflictLimit) {
+  backtrack(0);
+  if (!ok || (propagate() != -1)) {
+    ok = false;
+    return SAT_UNSAT;
+  }
+
+  long conflicts = 0;
+  vector<int> learnt;
+  for (int restart=0; ; restart++) {
+    long restartConflicts = luby(restart) * SAT_RESTART_BASE;
+
+    while (true) {
+      int confl = propagate();
+      if (confl != -1) {
+        numConflicts++;
+        conflicts++;
+        restartConflicts--;
+        if (decisionLevel() == 0) {
+          ok = false;
+          return SAT_UNSAT;
+        }
+
+        int btLevel;
+        analyze(confl, learnt, btLevel);
+        backtrack(btLevel);
+        if (learnt.size() == 1)
+          enqueue(learnt[0], -1);
+        else {
+          int ci = clauses.size();
+          clauses.push_back(learnt);
+          watches[learnt[0]].push_back(ci);
+          watches[learnt[1]].push_back(ci);
+          enqueue(learnt[0], ci);
+        }
+        varInc /= SAT_VAR_DECAY;
+        continue;
+      }
+
+      if (((conflictLimit >= 0) && (conflicts > conflictLimit)) ||
+          (stopFlag && stopFlag->load(memory_order_relaxed))) {
+        backtrack(0);
+        return SAT_UNKNOWN;
+      }
+      if (restartConflicts <= 0) {
+        backtrack(0);
+        break;
+      }
+
+      int l = pickBranchLit();
+      if (l == -1)
+        return SAT_SAT;
+      numDecisions++;
+      trailLim.push_back(trail.size());
+      enqueue(l, -1);
+    }
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef CLASSSATSOLVER_H
+#define CLASSSATSOLVER_H
+
+#include <vector>    // vector
+#include <atomic>    // atomic
+#include <stddef.h>  // NULL
+using namespace std;
+
+// Results of SatSolver::solve()
+#define SAT_UNKNOWN   -1   // the conflict limit was reached first
+#define SAT_UNSAT      0   // the clauses are unsatisfiable
+#define SAT_SAT        1   // a model was found (see SatSolver::getValue())
+
+// Conflicts before the first restart; restart i waits luby(i) times as long
+#define SAT_RESTART_BASE 100
+
+// VSIDS activities are divided by this after each conflict (by growing the bump instead)
+#define SAT_VAR_DECAY 0.95
+
+/** \brief Make the literal of variable \a v (negated if \a neg is true). */
+inline int satLit(int v, bool neg) { return 2*v + (neg ? 1 : 0); }
+
+class SatSolver{
+
+ private:
+  int numVars;
+  bool ok;                          // false once the clauses are known to be unsatisfiable
+  vector< vector<int> > clauses;    // Problem and learnt clauses; literal 2*v is v, 2*v+1 is not v
+  vector< vector<int> > watches;    // watches[l]: the clauses watching literal l (their first two literals)
+  vector<signed char> assigns;      // The value of each variable: 0, 1, or -1 if unassigned
+  vector<int> level;                // The decision level each variable was assigned at
+  vector<int> reason;               // The clause that implied each variable, or -1 for a decision
+  vector<int> trail;                // Assigned literals, in order of assignment
+  vector<int> trailLim;             // Where each decision level starts in trail
+  int qhead;                        // Literals of trail before qhead have been propagated
+  vector<double> activity;          // VSIDS activity of each variable
+  double varInc;                    // The amount a variable is bumped by
+  vector<int> heap;                 // Unassigned (and some assigned) variables, max-heap on activity
+  vector<int> heapPos;              // Position of each variable in heap, or -1
+  vector<char> polarity;            // The last value of each variable (phase saving)
+  vector<char> seen;                // Scratch flags for analyze()
+  long numConflicts;                // Conflicts over all calls to solve()
+  long numDecisions;                // Decisions over all calls to solve()
+  const atomic<bool>* stopFlag;     // If set and true, solve() gives up (see setStopFlag())
+
+  /** \brief The value of literal \a l: 1 (true), 0 (false), or -1 (unassigned). */
+  inline int value(int l) const { int a = assigns[l >> 1]; return (a < 0) ? -1 : (a ^ (l & 1)); }
+  inline int decisionLevel() const { return trailLim.size(); }
+
+  void enqueue(int l, int from);
+  int propagate();
+  void analyze(int confl, vector<int> &learnt, int &btLevel);
+  bool redundant(int l) const;
+  void backtrack(int lvl);
+  int pickBranchLit();
+  void bumpVar(int v);
+  void heapUp(int i);
+  void heapDown(int i);
+  void heapInsert(int v);
+  int heapPop();
+
+ public:
+  SatSolver();
+
+  int newVar();
+  int getNumberVars() const;
+  bool addClause(vector<int> lits);
+  int solve(long conflictLimit);
+  void setStopFlag(const atomic<bool>* stop);
+
+  /** \brief After solve() returns SAT_SAT, the value (0 or 1) of variable \a v in the model. */
+  inline int getValue(int v) const { return assigns[v]; }
+  long getNumConflicts() const;
+  long getNumDecisions() const;
+};
+
+#endif
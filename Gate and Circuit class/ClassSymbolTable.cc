@@ -0,0 +1,226 @@
+/** \class SymbolTable
+ * \brief An interned-name table mapping signal names to integer values (e.g. gate indices).
+ *
+ * Names are copied once into a single string pool, and looked up through an open-addressing
+ * hash table with linear probing. A Circuit keeps one of these to find gates by name; the
+ * parser fills it as gates are created, and setupCircuit() and the fault file reader use it
+ * for their lookups, so finding a gate no longer scans the whole circuit.
+ *
+ * If the same name is inserted twice, the table remembers that the name is ambiguous and
+ * \a find() returns SYMBOL_AMBIGUOUS for it.
+ *
+ * A name can also be interned before it has a value (\a intern()), e.g. when a netlist reader
+ * sees a signal used before the gate driving it; \a define() gives it its value later.
+ *
+ * Lookups read the table through a SymbolTableData, so a table saved with the rest of a
+ * compiled circuit can be used in place, from a memory-mapped file (see \a attach()).
+ */
+
+#include "ClassSymbolTable.h"
+#include <string.h>  // memcmp
+#include <assert.h>  // assert
+
+/** \brief Construct an empty symbol table. */
+SymbolTable::SymbolTable() {
+  slots.assign(16, 0);
+  slotMask = 15;
+  attached = false;
+  sync();
+}
+
+/** \brief Point data at the vectors, after they change. */
+void SymbolTable::sync() {
+  data.pool = pool.empty() ? NULL : &pool[0];
+  data.poolSize = pool.size();
+  data.nameStart = nameStart.empty() ? NULL : &nameStart[0];
+  data.nameLength = nameLength.empty() ? NULL : &nameLength[0];
+  data.nameHash = nameHash.empty() ? NULL : &nameHash[0];
+  data.nameValue = nameValue.empty() ? NULL : &nameValue[0];
+  data.numNames = nameHash.size();
+  data.slots = &slots[0];
+  data.numSlots = slots.size();
+}
+
+/** \brief Get the arrays the table reads, e.g. to save them. */
+const SymbolTableData& SymbolTable::getData() const { return data; }
+
+/** \brief Use arrays held elsewhere (e.g. in a mapped file) as the table, without copying them.
+ *  \param d The arrays, as getData() returned them for some table; they must outlive this table
+ *  \note The table is read-only after this: insert(), intern(), define() and reserve() may not be called.
+ */
+void SymbolTable::attach(const SymbolTableData& d) {
+  vector<char>().swap(pool);
+  vector<uint32_t>().swap(nameStart);
+  vector<uint32_t>().swap(nameLength);
+  vector<uint32_t>().swap(nameHash);
+  vector<int>().swap(nameValue);
+  vector<uint32_t>().swap(slots);
+  data = d;
+  slotMask = d.numSlots - 1;
+  attached = true;
+}
+
+/** \brief FNV-1a hash of a name.
+ *  \param s Pointer to the first character of the name
+ *  \param len Length of the name
+ */
+uint32_t SymbolTable::hashName(const char* s, int len) {
+  uint32_t h = 2166136261u;
+  for (int i=0; i<len; i++) {
+    h ^= (unsigned char)s[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/** \brief Find the hash table slot holding a name, or the empty slot where it would be inserted.
+ *  \param s Pointer to the first character of the name
+ *  \param len Length of the name
+ *  \param h The name's hash, from hashName()
+ */
+int SymbolTable::findSlot(const char* s, int len, uint32_t h) const {
+  uint32_t i = h & slotMask;
+  while (data.slots[i] != 0) {
+    uint32_t n = data.slots[i] - 1;
+    if ((data.nameHash[n] == h) && (data.nameLength[n] == (uint32_t)len) && (memcmp(data.pool + data.nameStart[n], s, len) == 0))
+      return i;
+    i = (i + 1) & slotMask;
+  }
+  return i;
+}
+
+/** \brief Double the size of the hash table, re-inserting every name. */
+void SymbolTable::grow() {
+  slots.assign(slots.size() * 2, 0);
+  slotMask = slots.size() - 1;
+  for (uint32_t n=0; n<nameHash.size(); n++) {
+    uint32_t i = nameHash[n] & slotMask;
+    while (slots[i] != 0)
+      i = (i + 1) & slotMask;
+    slots[i] = n + 1;
+  }
+  sync();
+}
+
+/** \brief Reserve space for \a n names, so that filling the table does not repeatedly regrow it.
+ *  \param n Expected number of names
+ */
+void SymbolTable::reserve(int n) {
+  assert(!attached);
+  nameStart.reserve(n);
+  nameLength.reserve(n);
+  nameHash.reserve(n);
+  nameValue.reserve(n);
+  while (slots.size() < 2 * (size_t)n)
+    grow();
+  sync();
+}
+
+/** \brief Add a name to the table.
+ *  \param s Pointer to the first character of the name (need not be '\\0'-terminated)
+ *  \param len Length of the name
+ *  \param value The value to store for this name (must be >= 0)
+ *  \return true if the name was new (or only interned); false if it already had a value (the name is then marked ambiguous)
+ */
+bool SymbolTable::insert(const char* s, int len, int value) {
+  assert((value >= 0) && !attached);
+  uint32_t h = hashName(s, len);
+  int slot = findSlot(s, len, h);
+  if (slots[slot] != 0)
+    return define(slots[slot]-1, value);
+
+  uint32_t n = nameHash.size();
+  nameStart.push_back(pool.size());
+  nameLength.push_back(len);
+  nameHash.push_back(h);
+  nameValue.push_back(value);
+  pool.insert(pool.end(), s, s+len);
+  pool.push_back('\0');
+  slots[slot] = n + 1;
+  sync();
+
+  // keep the load factor at or below 1/2
+  if (2 * nameHash.size() > slots.size())
+    grow();
+  return true;
+}
+
+/** \brief Add a name to the table.
+ *  \param name The name
+ *  \param value The value to store for this name (must be >= 0)
+ *  \return true if the name was new; false if it was already present (the name is then marked ambiguous)
+ */
+bool SymbolTable::insert(const string& name, int value) {
+  return insert(name.data(), name.size(), value);
+}
+
+/** \brief Get the index of a name, adding it (with no value yet) if it is new.
+ *  \param s Pointer to the first character of the name (need not be '\\0'-terminated)
+ *  \param len Length of the name
+ *  \return The name's index (as for getName()); find() returns SYMBOL_NOT_FOUND for it until define() is called
+ */
+int SymbolTable::intern(const char* s, int len) {
+  assert(!attached);
+  uint32_t h = hashName(s, len);
+  int slot = findSlot(s, len, h);
+  if (slots[slot] != 0)
+    return slots[slot] - 1;
+
+  uint32_t n = nameHash.size();
+  nameStart.push_back(pool.size());
+  nameLength.push_back(len);
+  nameHash.push_back(h);
+  nameValue.push_back(SYMBOL_NOT_FOUND);
+  pool.insert(pool.end(), s, s+len);
+  pool.push_back('\0');
+  slots[slot] = n + 1;
+  sync();
+
+  if (2 * nameHash.size() > slots.size())
+    grow();
+  return n;
+}
+
+/** \brief Give interned name \a i its value.
+ *  \param i The name's index, from intern()
+ *  \param value The value (must be >= 0)
+ *  \return true if the name had no value yet; false if it had one (it is then marked ambiguous)
+ */
+bool SymbolTable::define(int i, int value) {
+  assert((value >= 0) && !attached);
+  if (nameValue[i] != SYMBOL_NOT_FOUND) {
+    nameValue[i] = SYMBOL_AMBIGUOUS;
+    return false;
+  }
+  nameValue[i] = value;
+  return true;
+}
+
+/** \brief Get the value of the \a i th name: as find() returns it, without hashing the name. */
+int SymbolTable::getValue(int i) const { return data.nameValue[i]; }
+
+/** \brief Look up a name.
+ *  \param s Pointer to the first character of the name (need not be '\\0'-terminated)
+ *  \param len Length of the name
+ *  \return The value stored for the name, SYMBOL_NOT_FOUND, or SYMBOL_AMBIGUOUS if it was inserted more than once.
+ */
+int SymbolTable::find(const char* s, int len) const {
+  int slot = findSlot(s, len, hashName(s, len));
+  if (data.slots[slot] == 0)
+    return SYMBOL_NOT_FOUND;
+  return data.nameValue[data.slots[slot]-1];
+}
+
+/** \brief Look up a name.
+ *  \param name The name
+ *  \return The value stored for the name, SYMBOL_NOT_FOUND, or SYMBOL_AMBIGUOUS if it was inserted more than once.
+ */
+int SymbolTable::find(const string& name) const {
+  return find(name.data(), name.size());
+}
+
+/** \brief Get the number of distinct names in the table. */
+int SymbolTable::getNumberNames() const { return data.numNames; }
+
+/** \brief Get the \a i th interned name (in insertion order) as a '\\0'-terminated string. */
+const char* SymbolTable::getName(int i) const { return data.pool + data.nameStart[i]; }
@@ -0,0 +1,60 @@
+#ifndef CLASSSYMBOLTABLE_H
+#define CLASSSYMBOLTABLE_H
+
+#include <string>    // string
+#include <vector>    // vector
+#include <stdint.h>  // uint32_t
+using namespace std;
+
+// Values returned by SymbolTable::find()
+#define SYMBOL_NOT_FOUND  -1
+#define SYMBOL_AMBIGUOUS  -2
+
+/** @brief The arrays a SymbolTable reads (see SymbolTable::getData() and SymbolTable::attach()). */
+struct SymbolTableData {
+  const char* pool;            // All names, each followed by a '\0'
+  uint32_t poolSize;           // Bytes in pool
+  const uint32_t* nameStart;   // Offset of name i in the pool
+  const uint32_t* nameLength;  // Length of name i
+  const uint32_t* nameHash;    // Hash of name i
+  const int* nameValue;        // Value of name i (or SYMBOL_NOT_FOUND, SYMBOL_AMBIGUOUS)
+  uint32_t numNames;           // Number of names
+  const uint32_t* slots;       // Hash table: 0 is empty, otherwise name index + 1
+  uint32_t numSlots;           // Size of the hash table (a power of two)
+};
+
+class SymbolTable{
+
+ private:
+  vector<char> pool;              // All interned names, each followed by a '\0'
+  vector<uint32_t> nameStart;     // Offset of name i in the pool
+  vector<uint32_t> nameLength;    // Length of name i
+  vector<uint32_t> nameHash;      // Hash of name i (kept so the table can grow without rehashing strings)
+  vector<int> nameValue;          // Value (e.g. gate index) stored for name i, or SYMBOL_AMBIGUOUS
+  vector<uint32_t> slots;         // Open-addressing hash table: 0 is empty, otherwise name index + 1
+  uint32_t slotMask;              // slots.size() - 1 (the table size is always a power of two)
+  SymbolTableData data;           // What lookups read: the vectors above, or arrays given to attach()
+  bool attached;                  // True if data points at arrays given to attach() (the table is then read-only)
+
+  static uint32_t hashName(const char* s, int len);
+  int findSlot(const char* s, int len, uint32_t h) const;
+  void grow();
+  void sync();
+
+ public:
+  SymbolTable();
+  bool insert(const char* s, int len, int value);
+  bool insert(const string& name, int value);
+  int find(const char* s, int len) const;
+  int find(const string& name) const;
+  int intern(const char* s, int len);
+  bool define(int i, int value);
+  int getValue(int i) const;
+  int getNumberNames() const;
+  const char* getName(int i) const;
+  void reserve(int n);
+  const SymbolTableData& getData() const;
+  void attach(const SymbolTableData& d);
+};
+
+#endif
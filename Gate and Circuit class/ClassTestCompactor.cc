@@ -0,0 +1,180 @@
+/** \class TestCompactor
+ * \brief Static compaction of a test set: cube merging and reverse-order fault simulation.
+ *
+ * Test cubes (strings with one 0, 1 or X per PI, as in the output file) are stored as two packed
+ * bitmasks each: a care mask (which PIs are specified) and a value mask. Two cubes are compatible
+ * if they do not give a PI different values, i.e. (careA & careB & (valueA ^ valueB)) == 0, so
+ * checking a pair takes one word operation per 64 PIs.
+ *
+ * \a mergeCubes() merges compatible cubes, most-specified first, each into the first compatible
+ * merged cube. \a getPatterns() fills the X inputs of the result. \a reverseOrderSim() then drops the
+ * patterns that detect no fault that a later pattern does not already detect.
+ */
+
+#include "ClassTestCompactor.h"
+#include <algorithm> // stable_sort
+
+/** \brief Construct an empty compactor for tests of a circuit.
+ *  \param c The circuit; it must already be set up (see Circuit::setupCircuit()).
+ */
+TestCompactor::TestCompactor(const Circuit* c) {
+  circuit = c;
+  numPIs = c->getPIIndices().size();
+  numWords = (numPIs + 63) / 64;
+  numCubes = 0;
+}
+
+/** \brief Add a test cube (one 0, 1 or X per PI). */
+void TestCompactor::addCube(const string &cube) {
+  assert(cube.size() == numPIs);
+  care.resize(care.size() + numWords, 0);
+  value.resize(value.size() + numWords, 0);
+  uint64_t* cw = &care[numCubes*numWords];
+  uint64_t* vw = &value[numCubes*numWords];
+  for (int i=0; i<numPIs; i++) {
+    if (cube[i] == 'X')
+      continue;
+    cw[i/64] |= (uint64_t)1 << (i%64);
+    if (cube[i] == '1')
+      vw[i/64] |= (uint64_t)1 << (i%64);
+  }
+  numCubes++;
+}
+
+/** \brief Get the number of cubes (after mergeCubes(), the number of merged cubes). */
+int TestCompactor::getNumberCubes() const { return numCubes; }
+
+/** \brief Count the specified PIs of cube \a c. */
+int TestCompactor::countCare(int c) const {
+  int n = 0;
+  for (int w=0; w<numWords; w++)
+    for (uint64_t x = care[c*numWords + w]; x != 0; x &= x - 1)
+      n++;
+  return n;
+}
+
+/** \brief Merge compatible cubes.
+ *
+ * Cubes are taken in order of decreasing number of specified PIs (ties keep their order), and
+ * each one is merged into the first compatible merged cube among the last MERGE_WINDOW ones
+ * (or starts a new merged cube). Merging is just OR-ing the care and value masks.
+ */
+void TestCompactor::mergeCubes() {
+  vector<int> order(numCubes);
+  vector<int> numCare(numCubes);
+  for (int c=0; c<numCubes; c++) {
+    order[c] = c;
+    numCare[c] = countCare(c);
+  }
+  stable_sort(order.begin(), order.end(), [&numCare](int a, int b) { return numCare[a] > numCare[b]; });
+
+  vector<uint64_t> mCare, mValue;
+  int numMerged = 0;
+  for (int k=0; k<numCubes; k++) {
+    const uint64_t* cw = &care[order[k]*numWords];
+    const uint64_t* vw = &value[order[k]*numWords];
+
+    int m = (numMerged > MERGE_WINDOW) ? numMerged - MERGE_WINDOW : 0;
+    for (; m<numMerged; m++) {
+      bool ok = true;
+      for (int w=0; (w < numWords) && ok; w++)
+        if (cw[w] & mCare[m*numWords + w] & (vw[w] ^ mValue[m*numWords + w]))
+          ok = false;
+      if (ok)
+        break;
+    }
+
+    if (m == numMerged) {
+      mCare.insert(mCare.end(), cw, cw + numWords);
+      mValue.insert(mValue.end(), vw, vw + numWords);
+      numMerged++;
+    }
+    else {
+      for (int w=0; w<numWords; w++) {
+        mCare[m*numWords + w] |= cw[w];
+        mValue[m*numWords + w] |= vw[w];
+      }
+    }
+  }
+
+  care.swap(mCare);
+  value.swap(mValue);
+  numCubes = numMerged;
+}
+
+/** \brief Get the cubes as fully specified patterns.
+ *  \param fill Supplies the values of the X inputs
+ */
+vector<string> TestCompactor::getPatterns(Lfsr &fill) const {
+  vector<string> patterns(numCubes, string(numPIs, '0'));
+  for (int c=0; c<numCubes; c++) {
+    for (int i=0; i<numPIs; i++) {
+      int w = c*numWords + i/64;
+      uint64_t bit = (uint64_t)1 << (i%64);
+      if (care[w] & bit)
+        patterns[c][i] = (value[w] & bit) ? '1' : '0';
+      else
+        patterns[c][i] = fill.nextBit() ? '1' : '0';
+    }
+  }
+  return patterns;
+}
+
+/** \brief Reverse-order fault simulation: drop the patterns that are not needed.
+ *  \param faultSim The faults to cover. Every fault is marked not detected first.
+ *  \param patterns The fully specified patterns. On return, only those that are the last pattern
+ *  (in the original order) to detect some fault remain, still in order.
+ *  \return The number of faults the remaining patterns detect
+ *
+ * Patterns are simulated last to first, PATTERNS_PER_WORD at a time, and a pattern is kept if it is the first
+ * one simulated to detect some fault.
+ */
+int TestCompactor::reverseOrderSim(FaultSim &faultSim, vector<string> &patterns) {
+  faultSim.clearDetected();
+  int n = patterns.size();
+  vector<char> keep(n, 0);
+  vector<string> block;
+  vector<uint64_t> piWords;
+
+  for (int last=n-1; last>=0; last-=PATTERNS_PER_WORD) {
+    // bit k of the block is pattern last-k
+    block.clear();
+    for (int k=0; (k < PATTERNS_PER_WORD) && (last-k >= 0); k++)
+      block.push_back(patterns[last-k]);
+    packPatterns(block, 0, block.size(), piWords);
+    uint64_t mask = (block.size() == PATTERNS_PER_WORD) ? ~(uint64_t)0 : (((uint64_t)1 << block.size()) - 1);
+
+    faultSim.simulate(piWords, mask);
+    const vector<uint64_t>& words = faultSim.getLastDetectWords();
+    for (int i=0; i<words.size(); i++) {
+      int k = 0;
+      while (((words[i] >> k) & 1) == 0)
+        k++;
+      keep[last-k] = 1;
+    }
+  }
+
+  vector<string> kept;
+  for (int p=0; p<n; p++)
+    if (keep[p])
+      kept.push_back(patterns[p]);
+  patterns.swap(kept);
+  return faultSim.getNumberDetected();
+}
+
+/** \brief Pack fully specified patterns into PI words for FaultSim or ParallelSim.
+ *  \param patterns The patterns (one 0 or 1 per PI)
+ *  \param first The first pattern to pack
+ *  \param count How many to pack (at most PATTERNS_PER_WORD); pattern first+k goes in bit k
+ *  \param piWords Output: one word per PI
+ */
+void TestCompactor::packPatterns(const vector<string> &patterns, int first, int count, vector<uint64_t> &piWords) {
+  assert(count <= PATTERNS_PER_WORD);
+  piWords.assign(patterns[first].size(), 0);
+  for (int k=0; k<count; k++) {
+    const string &p = patterns[first+k];
+    for (int i=0; i<p.size(); i++)
+      if (p[i] == '1')
+        piWords[i] |= (uint64_t)1 << k;
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef CLASSTESTCOMPACTOR_H
+#define CLASSTESTCOMPACTOR_H
+
+#include "ClassCircuit.h"
+#include "ClassFaultSim.h"
+#include "ClassLfsr.h"
+#include <vector>    // vector
+#include <string>    // string
+#include <stdint.h>  // uint64_t
+using namespace std;
+
+// Cubes are only merged into one of this many most recently opened merged cubes, to bound the merge time
+#define MERGE_WINDOW 4096
+
+class TestCompactor{
+
+ private:
+  const Circuit* circuit;   // The circuit the tests are for
+  int numPIs;               // Number of PIs (characters per test)
+  int numWords;             // Words per cube in care and value (one bit per PI)
+  vector<uint64_t> care;    // Bit i of cube c is set if PI i is 0 or 1 (cube c is words c*numWords ..)
+  vector<uint64_t> value;   // Bit i of cube c is the value of PI i (0 where PI i is X)
+  int numCubes;             // Number of cubes
+
+  int countCare(int c) const;
+
+ public:
+  TestCompactor(const Circuit* c);
+
+  void addCube(const string &cube);
+  int getNumberCubes() const;
+  void mergeCubes();
+  vector<string> getPatterns(Lfsr &fill) const;
+
+  static int reverseOrderSim(FaultSim &faultSim, vector<string> &patterns);
+  static void packPatterns(const vector<string> &patterns, int first, int count, vector<uint64_t> &piWords);
+};
+
+#endif
@@ -0,0 +1,660 @@
+/** \class VerilogParser
+ * \brief Reads a flat structural Verilog netlist into a new Circuit.
+ *
+ * The file is read through a fixed-size buffer and parsed a token at a time, and gates are
+ * passed to the circuit by name index as they are read (see Circuit::internName()), so the
+ * parser itself only keeps the declared buses and one line number per signal: memory grows
+ * with the circuit, not the file. The circuit holds only its compiled form and names (no Gate
+ * objects, see Circuit::buildGates()); 1M two-input gates take about 300 MB once set up.
+ * A pipe can be read too (e.g. from zcat).
+ *
+ * The netlist is one module made of:
+ *
+ *     module top (a, b, y);          // or ANSI: module top (input [1:0] a, input b, output y);
+ *       input [1:0] a;               // inputs become PIs, outputs POs
+ *       input b;
+ *       output y;
+ *       wire [1:0] n;                // a range declares a bus
+ *       nand g1 (n[0], a[1], b), g2 (n[1], a[0], b);
+ *       not (y, w);                  // the instance name is optional
+ *       assign w = n[1];             // becomes a BUFF
+ *     endmodule
+ *
+ * Primitives and, nand, or, nor, xor, xnor, buf and not become the GATE_* type of the same
+ * name; the first terminal is the output (for buf and not, every terminal but the last is an
+ * output). Buses are bit-blasted: bit 3 of bus a is the signal "a[3]", the same name as the
+ * escaped identifier \\a[3]. A bus used whole, a part-select or a concatenation stands for its
+ * bits, most significant first; this is also the order the bits of an input or output bus are
+ * added as PIs or POs. Delays, drive strengths, attributes and compiler directives are skipped.
+ *
+ * The first error stops the parse and is reported with its line number (see getError()):
+ * syntax errors, module instances and other statements that are not gate primitives,
+ * expressions and constants, a signal driven twice, and a signal that is used but never driven.
+ */
+
+#include "ClassVerilogParser.h"
+#include <sstream>     // ostringstream
+#include <string.h>    // memmove, strcmp
+#include <stdlib.h>    // atoi
+#include <fcntl.h>     // open, posix_fadvise
+#include <unistd.h>    // read, close
+
+// Kinds of declaration (see VerilogParser::declarationKind())
+#define VDECL_NONE   -1
+#define VDECL_INPUT  0
+#define VDECL_OUTPUT 1
+#define VDECL_WIRE   2
+
+/** \brief Returns true if \a c can start an identifier. */
+static inline bool isNameStart(char c) {
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_');
+}
+
+/** \brief Returns true if \a c can be part of an identifier. */
+static inline bool isNameChar(char c) {
+  return isNameStart(c) || ((c >= '0') && (c <= '9')) || (c == '$');
+}
+
+/** \brief Returns true if \a c can be part of a number (including a based number, like 4'b10x1). */
+static inline bool isNumberChar(char c) {
+  return isNameChar(c) || (c == '\'') || (c == '.') || (c == '?');
+}
+
+/** \brief Returns true if \a c is white space. */
+static inline bool isSpace(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\f') || (c == '\v');
+}
+
+/** \brief Construct a parser. */
+VerilogParser::VerilogParser() {
+  fd = -1;
+  pos = end = NULL;
+  atEOF = true;
+  line = 0;
+  tok = VTOK_END;
+  tokEscaped = false;
+  tokLine = 0;
+  circuit = NULL;
+  seenModule = false;
+}
+
+/** \brief Get the first error found by the last parse() (empty if it succeeded),
+ *  as "file:line: message". */
+const string& VerilogParser::getError() const { return error; }
+
+/** \brief Record an error (if it is the first one).
+ *  \param errLine The line it is on
+ *  \param msg What is wrong
+ *  \return false, so parse functions can "return fail(...)"
+ */
+bool VerilogParser::fail(int errLine, const string& msg) {
+  if (error.empty()) {
+    ostringstream ss;
+    ss << fileName << ":" << errLine << ": " << msg;
+    error = ss.str();
+  }
+  return false;
+}
+
+/** \brief Describe the current token, for error messages. */
+string VerilogParser::found() const {
+  return (tok == VTOK_END) ? string("end of file") : "'" + tokText + "'";
+}
+
+/** \brief Make sure at least \a need characters are buffered at pos, reading more of the file
+ *  if needed (fewer are left at the end of the file).
+ *  \return false if there is nothing left to read
+ */
+bool VerilogParser::fill(size_t need) {
+  if ((end - pos >= need) || atEOF)
+    return pos < end;
+
+  // keep what is left, and fill the rest of the buffer
+  char* b = &buffer[0];
+  size_t left = end - pos;
+  memmove(b, pos, left);
+  pos = b;
+  end = b + left;
+  while (!atEOF && (end < b + buffer.size())) {
+    ssize_t n = read(fd, b + (end - b), buffer.size() - (end - b));
+    if (n < 0)
+      fail(line, "cannot read file");
+    if (n <= 0)
+      atEOF = true;
+    else
+      end += n;
+  }
+  return pos < end;
+}
+
+/** \brief Skip white space, comments, attributes and compiler directives, counting lines.
+ *  \return false on an unterminated comment
+ */
+bool VerilogParser::skipSpace() {
+  while (fill(2)) {
+    char c = *pos;
+    char c2 = (end - pos > 1) ? pos[1] : '\0';
+    if (c == '\n') {
+      line++;
+      pos++;
+    }
+    else if (isSpace(c))
+      pos++;
+    else if ((c == '/') && (c2 == '/')) {
+      while (fill(1) && (*pos != '\n'))
+        pos++;
+    }
+    else if ((c == '`') || ((c == '/') && (c2 == '*')) || ((c == '(') && (c2 == '*'))) {
+      if (c == '`') {
+        // a directive, like `timescale: skip the line
+        while (fill(1) && (*pos != '\n'))
+          pos++;
+        continue;
+      }
+      // a comment or an attribute (* ... *)
+      int startLine = line;
+      char close = (c == '/') ? '/' : ')';
+      pos += 2;
+      while (true) {
+        if (!fill(2))
+          return fail(startLine, (c == '/') ? "unterminated comment" : "unterminated attribute");
+        if ((*pos == '*') && (end - pos > 1) && (pos[1] == close)) {
+          pos += 2;
+          break;
+        }
+        if (*pos == '\n')
+          line++;
+        pos++;
+      }
+    }
+    else
+      return true;
+  }
+  return error.empty();
+}
+
+/** \brief Read the next token into tok, tokText, tokEscaped and tokLine.
+ *  \return false on an error
+ */
+bool VerilogParser::next() {
+  if (!skipSpace())
+    return false;
+  tokLine = line;
+  tokEscaped = false;
+  if (!fill(VERILOG_MAX_TOKEN)) {
+    tok = VTOK_END;
+    tokText.clear();
+    return true;
+  }
+
+  const char* s = pos;
+  char c = *pos;
+  if (c == '\\') {
+    // an escaped identifier runs up to white space
+    s = ++pos;
+    while ((pos < end) && !isSpace(*pos))
+      pos++;
+    if (pos == s)
+      return fail(tokLine, "empty escaped identifier");
+    tok = VTOK_NAME;
+    tokEscaped = true;
+  }
+  else if (isNameStart(c)) {
+    while ((pos < end) && isNameChar(*pos))
+      pos++;
+    tok = VTOK_NAME;
+  }
+  else if (((c >= '0') && (c <= '9')) || (c == '\'')) {
+    while ((pos < end) && isNumberChar(*pos))
+      pos++;
+    tok = VTOK_NUMBER;
+  }
+  else {
+    pos++;
+    tok = c;
+  }
+  if ((pos == end) && !atEOF)
+    return fail(tokLine, "token longer than " + to_string(VERILOG_MAX_TOKEN) + " characters");
+  tokText.assign(s, pos - s);
+  return true;
+}
+
+/** \brief Returns true if the current token is the keyword \a word. */
+bool VerilogParser::isKeyword(const char* word) const {
+  return (tok == VTOK_NAME) && !tokEscaped && (tokText == word);
+}
+
+/** \brief Returns the VDECL_* kind of declaration the current token starts, or VDECL_NONE. */
+int VerilogParser::declarationKind() const {
+  if (isKeyword("input"))
+    return VDECL_INPUT;
+  if (isKeyword("output"))
+    return VDECL_OUTPUT;
+  if (isKeyword("wire") || isKeyword("tri"))
+    return VDECL_WIRE;
+  return VDECL_NONE;
+}
+
+/** \brief Returns the GATE_* type of the gate primitive the current token names, or -1. */
+int VerilogParser::primitiveType() const {
+  static const struct { const char* word; int type; } primitives[] = {
+    { "nand", GATE_NAND }, { "nor", GATE_NOR }, { "and", GATE_AND }, { "or", GATE_OR },
+    { "xor", GATE_XOR }, { "xnor", GATE_XNOR }, { "buf", GATE_BUFF }, { "not", GATE_NOT }
+  };
+  for (int i=0; i<sizeof(primitives)/sizeof(primitives[0]); i++)
+    if (isKeyword(primitives[i].word))
+      return primitives[i].type;
+  return -1;
+}
+
+/** \brief Returns true if the current token is a drive strength, like strong0. */
+bool VerilogParser::isStrength() const {
+  static const char* strengths[] = { "supply0", "strong0", "pull0", "weak0", "highz0",
+                                     "supply1", "strong1", "pull1", "weak1", "highz1" };
+  for (int i=0; i<sizeof(strengths)/sizeof(strengths[0]); i++)
+    if (isKeyword(strengths[i]))
+      return true;
+  return false;
+}
+
+/** \brief Read the character \a c; an error if it is not the current token. */
+bool VerilogParser::expect(char c) {
+  if (tok != c)
+    return fail(tokLine, string("expected '") + c + "' but found " + found());
+  return next();
+}
+
+/** \brief Read a (decimal) number. */
+bool VerilogParser::readNumber(int &n) {
+  if ((tok != VTOK_NUMBER) || (tokText.find_first_not_of("0123456789") != string::npos))
+    return fail(tokLine, "expected a number but found " + found());
+  n = atoi(tokText.c_str());
+  return next();
+}
+
+/** \brief Get the circuit's name index for a signal name, noting the line where it first appears. */
+int VerilogParser::nameIndex(const string& name, int useLine) {
+  int i = circuit->internName(name.data(), name.size());
+  if (i == firstUse.size())
+    firstUse.push_back(useLine);
+  return i;
+}
+
+/** \brief Get the name index of bit \a bit of bus \a base, the signal "base[bit]". */
+int VerilogParser::bitIndex(const string& base, int bit, int useLine) {
+  bitName = base;
+  bitName += '[';
+  bitName += to_string(bit);
+  bitName += ']';
+  return nameIndex(bitName, useLine);
+}
+
+/** \brief Read a range, [msb:lsb]. */
+bool VerilogParser::readRange(BusRange &r) {
+  return expect('[') && readNumber(r.msb) && expect(':') && readNumber(r.lsb) && expect(']');
+}
+
+/** \brief Skip a delay (#3 or #(1, 2)), if there is one. */
+bool VerilogParser::skipDelay() {
+  if (tok != '#')
+    return true;
+  if (!next())
+    return false;
+  if (tok != '(')
+    return next();
+  for (int depth = 0; ; ) {
+    if (tok == '(')
+      depth++;
+    else if (tok == ')')
+      depth--;
+    else if (tok == VTOK_END)
+      return fail(tokLine, "unterminated delay");
+    if (!next())
+      return false;
+    if (depth == 0)
+      return true;
+  }
+}
+
+/** \brief Read a reference to signals: a name, a bus, a bit or part of a bus, or a
+ *  concatenation of those.
+ *  \param out Output: the name index of each bit is appended, most significant first
+ */
+bool VerilogParser::readNetRef(vector<int> &out) {
+  if (tok == '{') {
+    if (!next())
+      return false;
+    while (true) {
+      if (!readNetRef(out))
+        return false;
+      if (tok != ',')
+        return expect('}');
+      if (!next())
+        return false;
+    }
+  }
+  if (tok == VTOK_NUMBER)
+    return fail(tokLine, "constant " + tokText + " is not supported (the circuit has no constant signals)");
+  if (tok != VTOK_NAME)
+    return fail(tokLine, "expected a signal but found " + found());
+
+  string base = tokText;
+  int refLine = tokLine;
+  if (!next())
+    return false;
+  unordered_map<string, BusRange>::const_iterator bus = buses.empty() ? buses.end() : buses.find(base);
+  if ((bus == buses.end()) && (tok != '[')) {
+    out.push_back(nameIndex(base, refLine));
+    return true;
+  }
+  if (bus == buses.end())
+    return fail(refLine, base + " is not declared as a bus");
+
+  // the whole bus, one bit, or a part-select
+  int hi = bus->second.msb, lo = bus->second.lsb;
+  if (tok == '[') {
+    if (!next() || !readNumber(hi))
+      return false;
+    lo = hi;
+    if ((tok == ':') && (!next() || !readNumber(lo)))
+      return false;
+    if (!expect(']'))
+      return false;
+    int low = min(bus->second.msb, bus->second.lsb), high = max(bus->second.msb, bus->second.lsb);
+    if ((hi < low) || (hi > high) || (lo < low) || (lo > high))
+      return fail(refLine, "bit out of range of bus " + base);
+  }
+  int step = (hi >= lo) ? -1 : 1;
+  for (int b=hi; ; b+=step) {
+    out.push_back(bitIndex(base, b, refLine));
+    if (b == lo)
+      break;
+  }
+  return true;
+}
+
+/** \brief Declare a signal or bus, adding a PI for each bit of an input and a PO for each bit
+ *  of an output.
+ *  \param name The signal name
+ *  \param kind VDECL_INPUT, VDECL_OUTPUT or VDECL_WIRE
+ *  \param isBus True if it was declared with a range
+ *  \param r The range
+ *  \param declLine The line it is declared on
+ */
+bool VerilogParser::declare(const string& name, int kind, bool isBus, const BusRange& r, int declLine) {
+  if (isBus) {
+    unordered_map<string, BusRange>::iterator bus = buses.find(name);
+    if (bus == buses.end())
+      buses[name] = r;
+    else if ((bus->second.msb != r.msb) || (bus->second.lsb != r.lsb))
+      return fail(declLine, "bus " + name + " is declared again with a different range");
+  }
+  if (kind == VDECL_WIRE)
+    return true;
+
+  int step = (r.msb >= r.lsb) ? -1 : 1;
+  for (int b=r.msb; ; b+=step) {
+    int n = isBus ? bitIndex(name, b, declLine) : nameIndex(name, declLine);
+    if (kind == VDECL_OUTPUT)
+      circuit->addOutput(n);
+    else if (!circuit->newGate(n, GATE_PI))
+      return fail(declLine, "signal " + string(circuit->getName(n)) + " is driven twice");
+    if (!isBus || (b == r.lsb))
+      return true;
+  }
+}
+
+/** \brief Parse a declaration (input, output, wire or tri), up to its ';'. In an ANSI port
+ *  list it ends at the ')' or at the next declaration, after the ','.
+ */
+bool VerilogParser::parseDeclaration() {
+  int kind = declarationKind();
+  if (!next())
+    return false;
+  if ((kind != VDECL_WIRE) && (declarationKind() == VDECL_WIRE) && !next())
+    return false;
+  BusRange r = { 0, 0 };
+  bool isBus = (tok == '[');
+  if (isBus && !readRange(r))
+    return false;
+
+  while (true) {
+    if (tok != VTOK_NAME)
+      return fail(tokLine, "expected a signal name but found " + found());
+    string name = tokText;
+    int declLine = tokLine;
+    if (!next() || !declare(name, kind, isBus, r, declLine))
+      return false;
+    if (tok != ',')
+      return true;
+    if (!next())
+      return false;
+    if (declarationKind() != VDECL_NONE)
+      return true;
+  }
+}
+
+/** \brief Parse a module's port list, from its '(': port names, or ANSI declarations. */
+bool VerilogParser::parsePorts() {
+  if (!next())
+    return false;
+  while (tok != ')') {
+    if (declarationKind() != VDECL_NONE) {
+      if (!parseDeclaration())
+        return false;
+      continue;
+    }
+    if (tok != VTOK_NAME)
+      return fail(tokLine, "expected a port name but found " + found());
+    if (!next())
+      return false;
+    if (tok == ',') {
+      if (!next())
+        return false;
+    }
+    else if (tok != ')')
+      return fail(tokLine, "expected ')' but found " + found());
+  }
+  return next();
+}
+
+/** \brief Parse an assign statement: each bit of the left-hand side becomes a BUFF of the
+ *  same bit of the right-hand side. */
+bool VerilogParser::parseAssign() {
+  if (!next() || !skipDelay())
+    return false;
+  while (true) {
+    int assignLine = tokLine;
+    bits.clear();
+    rhsBits.clear();
+    if (!readNetRef(bits) || !expect('=') || !readNetRef(rhsBits))
+      return false;
+    if ((tok != ',') && (tok != ';'))
+      return fail(tokLine, "only assignments of one signal to another are supported (found " + found() + ")");
+    if (bits.size() != rhsBits.size())
+      return fail(assignLine, "assignment of " + to_string(rhsBits.size()) + " bits to " + to_string(bits.size()) + " bits");
+    for (int i=0; i<bits.size(); i++) {
+      if (!circuit->newGate(bits[i], GATE_BUFF))
+        return fail(assignLine, "signal " + string(circuit->getName(bits[i])) + " is driven twice");
+      circuit->addGateInput(rhsBits[i]);
+    }
+    if (tok == ';')
+      return next();
+    if (!next())
+      return false;
+  }
+}
+
+/** \brief Parse the instances of a gate primitive, up to the ';'.
+ *  \param type The GATE_* type it is
+ */
+bool VerilogParser::parsePrimitive(int type) {
+  if (!next())
+    return false;
+
+  // a drive strength, or the terminals of an instance with no name
+  bool inTerminals = false;
+  if (tok == '(') {
+    if (!next())
+      return false;
+    if (isStrength()) {
+      while (tok != ')') {
+        if ((tok == VTOK_END) || !next())
+          return fail(tokLine, "unterminated drive strength");
+      }
+      if (!next())
+        return false;
+    }
+    else
+      inTerminals = true;
+  }
+  if (!inTerminals && !skipDelay())
+    return false;
+
+  while (true) {
+    int instLine = tokLine;
+    if (!inTerminals) {
+      if (tok == VTOK_NAME) {
+        if (!next())
+          return false;
+        if (tok == '[')
+          return fail(instLine, "arrays of instances are not supported");
+      }
+      if (!expect('('))
+        return false;
+    }
+    inTerminals = false;
+
+    bits.clear();
+    while (true) {
+      size_t before = bits.size();
+      if (!readNetRef(bits))
+        return false;
+      if (bits.size() != before + 1)
+        return fail(instLine, "each terminal of a gate primitive must be a single bit");
+      if (tok != ',')
+        break;
+      if (!next())
+        return false;
+    }
+    if (!expect(')'))
+      return false;
+
+    // the first terminal is the output (all but the last, for buf and not); the rest are inputs
+    int n = bits.size();
+    if (n < 2)
+      return fail(instLine, "a gate primitive needs an output and at least one input");
+    int numOutputs = ((type == GATE_BUFF) || (type == GATE_NOT)) ? n-1 : 1;
+    for (int o=0; o<numOutputs; o++) {
+      if (!circuit->newGate(bits[o], type))
+        return fail(instLine, "signal " + string(circuit->getName(bits[o])) + " is driven twice");
+      for (int i=numOutputs; i<n; i++)
+        circuit->addGateInput(bits[i]);
+    }
+
+    if (tok == ';')
+      return next();
+    if (!expect(','))
+      return false;
+  }
+}
+
+/** \brief Parse a module, from "module" to "endmodule". */
+bool VerilogParser::parseModule() {
+  if (seenModule)
+    return fail(tokLine, "only one module is supported (the netlist must be flat)");
+  seenModule = true;
+  if (!next())
+    return false;
+  if (tok != VTOK_NAME)
+    return fail(tokLine, "expected a module name but found " + found());
+  if (!next())
+    return false;
+  if (tok == '#')
+    return fail(tokLine, "module parameters are not supported");
+  if ((tok == '(') && !parsePorts())
+    return false;
+  if (!expect(';'))
+    return false;
+
+  while (!isKeyword("endmodule")) {
+    if (tok == VTOK_END)
+      return fail(tokLine, "missing endmodule");
+    if (tok != VTOK_NAME)
+      return fail(tokLine, "expected a declaration, assign or gate but found " + found());
+    int type = primitiveType();
+    bool ok;
+    if (declarationKind() != VDECL_NONE)
+      ok = parseDeclaration() && expect(';');
+    else if (isKeyword("assign"))
+      ok = parseAssign();
+    else if (type >= 0)
+      ok = parsePrimitive(type);
+    else
+      return fail(tokLine, "unsupported statement or module instance " + found() +
+                  " (only declarations, assign and gate primitives are supported)");
+    if (!ok)
+      return false;
+  }
+  return next();
+}
+
+/** \brief Parse the whole file (it is open on fd). */
+bool VerilogParser::parse() {
+  if (!next())
+    return false;
+  while (tok != VTOK_END) {
+    if (!isKeyword("module"))
+      return fail(tokLine, "expected module but found " + found());
+    if (!parseModule())
+      return false;
+  }
+  if (!seenModule)
+    return fail(line, "no module found");
+
+  // every signal used must be driven by something
+  for (int i=0; i<firstUse.size(); i++)
+    if (circuit->getNameGate(i) == SYMBOL_NOT_FOUND)
+      return fail(firstUse[i], "signal " + string(circuit->getName(i)) + " is used but never driven");
+  return error.empty();
+}
+
+/** \brief Parse a Verilog file.
+ *  \param file The file name
+ *  \return The new circuit (not set up yet, see Circuit::setupCircuit()), or NULL on an error (see getError())
+ */
+Circuit* VerilogParser::parse(const string& file) {
+  fileName = file;
+  error.clear();
+  fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = file + ": cannot open file";
+    return NULL;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  buffer.resize(VERILOG_BUFFER_SIZE);
+  pos = end = &buffer[0];
+  atEOF = false;
+  line = 1;
+  seenModule = false;
+  buses.clear();
+  firstUse.clear();
+  circuit = new Circuit;
+
+  bool ok = parse();
+  close(fd);
+  fd = -1;
+  vector<char>().swap(buffer);
+  vector<int>().swap(firstUse);
+  buses.clear();
+  pos = end = NULL;
+
+  if (!ok) {
+    delete circuit;
+    circuit = NULL;
+  }
+  Circuit* c = circuit;
+  circuit = NULL;
+  return c;
+}
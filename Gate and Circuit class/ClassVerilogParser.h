@@ -0,0 +1,81 @@
+#ifndef CLASSVERILOGPARSER_H
+#define CLASSVERILOGPARSER_H
+
+#include "ClassCircuit.h"
+#include <string>         // string
+#include <vector>         // vector
+#include <unordered_map>  // unordered_map
+using namespace std;
+
+// Size of the buffer the file is read through, and the longest token it allows
+#define VERILOG_BUFFER_SIZE (1 << 20)
+#define VERILOG_MAX_TOKEN   (1 << 16)
+
+// Token types (see VerilogParser::next()); any other token is a single character, e.g. '('
+#define VTOK_END    0    // end of file
+#define VTOK_NAME   -1   // an identifier or keyword (an escaped identifier is never a keyword)
+#define VTOK_NUMBER -2   // a number, e.g. 3, 1.5 or 4'b1010
+
+/** @brief The bits of a bus, as declared: [msb:lsb]. */
+struct BusRange {
+  int msb;
+  int lsb;
+};
+
+class VerilogParser{
+
+ private:
+  int fd;                               // The file being read
+  vector<char> buffer;                  // The part of the file being parsed
+  const char* pos;                      // Next character to read, in buffer
+  const char* end;                      // One past the last character read into buffer
+  bool atEOF;                           // True once the whole file has been read into buffer
+  int line;                             // Line number of pos (from 1)
+
+  int tok;                              // The current token: VTOK_* or a character
+  string tokText;                       // Its text (without the '\' of an escaped identifier)
+  bool tokEscaped;                      // True if it is an escaped identifier
+  int tokLine;                          // The line it is on
+
+  Circuit* circuit;                     // The circuit being built
+  bool seenModule;                      // True once the module has been read
+  unordered_map<string, BusRange> buses; // Every net declared with a range
+  vector<int> firstUse;                 // Line where each signal name (by name index) was first seen
+  vector<int> bits;                     // Scratch: name indices of the bits of a port or assignment
+  vector<int> rhsBits;                  // Scratch: the right-hand side of an assignment
+  string bitName;                       // Scratch: the name of one bit of a bus
+  string fileName;                      // The file being parsed, for error messages
+  string error;                         // The first error found, or empty
+
+  bool fail(int errLine, const string& msg);
+  bool fill(size_t need);
+  bool skipSpace();
+  bool next();
+  string found() const;
+  bool isKeyword(const char* word) const;
+  int declarationKind() const;
+  int primitiveType() const;
+  bool isStrength() const;
+  bool expect(char c);
+  bool readNumber(int &n);
+  int nameIndex(const string& name, int useLine);
+  int bitIndex(const string& base, int bit, int useLine);
+  bool readRange(BusRange &r);
+  bool skipDelay();
+  bool readNetRef(vector<int> &out);
+  bool declare(const string& name, int kind, bool isBus, const BusRange& r, int declLine);
+  bool parseDeclaration();
+  bool parsePorts();
+  bool parseAssign();
+  bool parsePrimitive(int type);
+  bool parseModule();
+  bool parse();
+
+ public:
+  VerilogParser();
+
+  Circuit* parse(const string& file);
+  const string& getError() const;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/** \class WorkQueue
+ * \brief A work-stealing queue of integer tasks, shared by a fixed number of worker threads.
+ *
+ * Each worker has its own double-ended queue. A worker takes tasks from the front of its own
+ * queue; when that is empty, it steals one task from the back of another worker's queue.
+ * So workers that get easy tasks keep taking work from workers that are stuck on hard ones.
+ * All functions may be called from any thread.
+ */
+
+#include "ClassWorkQueue.h"
+
+/** \brief Construct a queue with no tasks.
+ *  \param numWorkers The number of workers (numbered 0 .. numWorkers-1)
+ */
+WorkQueue::WorkQueue(int numWorkers) : tasks(numWorkers), locks(numWorkers) {
+}
+
+/** \brief Get the number of workers. */
+int WorkQueue::getNumberWorkers() const { return tasks.size(); }
+
+/** \brief Add a task to the back of worker \a w's queue. */
+void WorkQueue::push(int w, int task) {
+  lock_guard<mutex> guard(locks[w]);
+  tasks[w].push_back(task);
+}
+
+/** \brief Get the next task for worker \a w.
+ *  \param w The worker asking for a task
+ *  \param task Output: the task
+ *  \return false if every queue is empty
+ *  \note Tasks are never added while workers run, so once this returns false, there is no more work.
+ */
+bool WorkQueue::pop(int w, int &task) {
+  {
+    lock_guard<mutex> guard(locks[w]);
+    if (!tasks[w].empty()) {
+      task = tasks[w].front();
+      tasks[w].pop_front();
+      return true;
+    }
+  }
+
+  // Our own queue is empty: steal from the other workers, in turn.
+  for (int i=1; i<tasks.size(); i++) {
+    int v = (w + i) % tasks.size();
+    lock_guard<mutex> guard(locks[v]);
+    if (!tasks[v].empty()) {
+      task = tasks[v].back();
+      tasks[v].pop_back();
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,22 @@
+#ifndef CLASSWORKQUEUE_H
+#define CLASSWORKQUEUE_H
+
+#include <vector>    // vector
+#include <deque>     // deque
+#include <mutex>     // mutex
+using namespace std;
+
+class WorkQueue{
+
+ private:
+  vector< deque<int> > tasks;  // tasks[w] holds the tasks queued for worker w
+  vector<mutex> locks;         // locks[w] guards tasks[w]
+
+ public:
+  WorkQueue(int numWorkers);
+  int getNumberWorkers() const;
+  void push(int w, int task);
+  bool pop(int w, int &task);
+};
+
+#endif
@@ -0,0 +1,241 @@
+/** @file KernelBench.cc
+ * @brief Micro-benchmark of 5-valued gate evaluation: the old vector-based functions
+ * (evalGate, EvalXORGate and LogicNot, as AtpgEngine had them) against LogicKernel and
+ * the dual-rail encoding (DualRail), both one value at a time and 64 lanes per word.
+ *
+ * Usage: ./kernelbench [evaluations]
+ *
+ * It first checks that all of them give the same result for every gate type and every input
+ * combination of up to 4 inputs, then times each on the same random gates and values,
+ * and prints gate evaluations per second. Build with "make kernelbench".
+ */
+
+#include "ClassLogicKernel.h"
+#include "ClassDualRail.h"
+#include "ClassParallelSim.h"  // PATTERNS_PER_WORD
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdlib.h>
+using namespace std;
+
+char oldEvalGate(vector<char> in, int c, int i);
+char oldEvalXORGate(vector<char> in, int inv);
+int oldLogicNot(int logicVal);
+
+// Number of gates (and gate values) in the random benchmark netlist
+#define BENCH_GATES 4096
+
+/** @brief Evaluate a gate the old way: copy its fanin values into a vector and dispatch on the type. */
+char oldSimGate(char gateType, const char* values, const uint32_t* fanin, int n) {
+  vector<char> inputVals;
+  for (int i=0; i<n; i++)
+    inputVals.push_back(values[fanin[i]]);
+
+  switch(gateType) {
+  case GATE_NAND: return oldEvalGate(inputVals, 0, 1);
+  case GATE_NOR: return oldEvalGate(inputVals, 1, 1);
+  case GATE_AND: return oldEvalGate(inputVals, 0, 0);
+  case GATE_OR: return oldEvalGate(inputVals, 1, 0);
+  case GATE_BUFF: return inputVals[0];
+  case GATE_NOT: return oldLogicNot(inputVals[0]);
+  case GATE_XOR: return oldEvalXORGate(inputVals, 0);
+  case GATE_XNOR: return oldEvalXORGate(inputVals, 1);
+  case GATE_FANOUT: return inputVals[0];
+  }
+  return LOGIC_X;
+}
+
+int main(int argc, char* argv[]) {
+  long numEvals = (argc > 1) ? atol(argv[1]) : 20000000;
+  const char types[] = { GATE_NAND, GATE_NOR, GATE_AND, GATE_OR, GATE_XOR, GATE_XNOR, GATE_BUFF, GATE_NOT, GATE_FANOUT };
+  const int numTypes = sizeof(types);
+
+  // Check: every type, every combination of 1 to 4 input values.
+  char values[5] = { LOGIC_ZERO, LOGIC_ONE, LOGIC_D, LOGIC_DBAR, LOGIC_X };
+  DualRail rails[5];
+  for (int v=0; v<5; v++)
+    rails[v] = DualRail::fromLogic(values[v]);
+  long numChecked = 0;
+  for (int t=0; t<numTypes; t++) {
+    int maxInputs = ((types[t] == GATE_BUFF) || (types[t] == GATE_NOT) || (types[t] == GATE_FANOUT)) ? 1 : 4;
+    for (int n=1; n<=maxInputs; n++) {
+      int combos = 1;
+      for (int i=0; i<n; i++)
+        combos *= 5;
+      for (int k=0; k<combos; k++) {
+        uint32_t fanin[4];
+        for (int i=0, x=k; i<n; i++, x/=5)
+          fanin[i] = x % 5;
+        char a = oldSimGate(types[t], values, fanin, n);
+        char b = LogicKernel::evalGate(types[t], values, fanin, n);
+        char c = DualRail::evalLogicGate(types[t], values, fanin, n);
+        char d = DualRail::evalGate(types[t], rails, fanin, n).toLogic(PATTERNS_PER_WORD - 1);
+        if ((a != b) || (a != c) || (a != d)) {
+          cout << "MISMATCH: gate type " << (int)types[t] << ", " << n << " inputs, combination " << k
+               << ": old " << (int)a << ", kernel " << (int)b << ", dual-rail " << (int)c << " / " << (int)d << endl;
+          return 1;
+        }
+        numChecked++;
+      }
+    }
+  }
+  cout << "Checked " << numChecked << " input combinations: same results" << endl;
+
+  // Random gates (mostly 2 to 4 inputs) over random values.
+  mt19937 rng(1);
+  vector<char> gateValues(BENCH_GATES);
+  vector<char> gateType(BENCH_GATES);
+  vector<uint32_t> faninStart(BENCH_GATES + 1, 0);
+  vector<uint32_t> fanin;
+  for (int g=0; g<BENCH_GATES; g++) {
+    gateValues[g] = values[rng() % 5];
+    gateType[g] = types[rng() % numTypes];
+    int n = ((gateType[g] == GATE_BUFF) || (gateType[g] == GATE_NOT) || (gateType[g] == GATE_FANOUT)) ? 1 : 2 + rng() % 3;
+    for (int i=0; i<n; i++)
+      fanin.push_back(rng() % BENCH_GATES);
+    faninStart[g+1] = fanin.size();
+  }
+
+  vector<DualRail> gateRails(BENCH_GATES);
+  for (int g=0; g<BENCH_GATES; g++)
+    for (int k=0; k<PATTERNS_PER_WORD; k++) {
+      char v = values[rng() % 5];
+      const DualRail& r = DualRail::fromLogic(v);
+      uint64_t bit = (uint64_t)1 << k;
+      gateRails[g].good1 |= r.good1 & bit;
+      gateRails[g].good0 |= r.good0 & bit;
+      gateRails[g].faulty1 |= r.faulty1 & bit;
+      gateRails[g].faulty0 |= r.faulty0 & bit;
+    }
+
+  const char* names[4] = { "old evalGate/EvalXORGate: ", "LogicKernel:              ",
+                           "DualRail, one value:      ", "DualRail, 64 lanes:       " };
+  for (int pass=0; pass<4; pass++) {
+    long sum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long e=0; e<numEvals; e++) {
+      int g = e % BENCH_GATES;
+      const uint32_t* in = &fanin[faninStart[g]];
+      int n = faninStart[g+1] - faninStart[g];
+      if (pass == 0)
+        sum += oldSimGate(gateType[g], &gateValues[0], in, n);
+      else if (pass == 1)
+        sum += LogicKernel::evalGate(gateType[g], &gateValues[0], in, n);
+      else if (pass == 2)
+        sum += DualRail::evalLogicGate(gateType[g], &gateValues[0], in, n);
+      else
+        sum += __builtin_popcountll(DualRail::evalGate(gateType[g], &gateRails[0], in, n).diff());
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << names[pass] << numEvals / elapsed.count() / 1e6 << " M gate evaluations/s";
+    if (pass == 3)
+      cout << " (" << numEvals / elapsed.count() / 1e6 * PATTERNS_PER_WORD << " M values/s)";
+    cout << " (checksum " << sum << ")" << endl;
+  }
+  return 0;
+}
+
+
+/** @brief Evaluate a NAND, NOR, AND, or OR gate.
+ * \param in The logic value's of this gate's inputs.
+ * \param c The controlling value of this gate type (e.g. c==0 for an AND or NAND gate)
+ * \param i The inverting value for this gate (e.g. i==0 for AND and i==1 for NAND)
+ * \returns The logical value produced by this gate (not including a possible fault on this gate).
+ */
+char oldEvalGate(vector<char> in, int c, int i) {
+
+  // Are any of the inputs of this gate the controlling value?
+  bool anyC = find(in.begin(), in.end(), c) != in.end();
+  
+  // Are any of the inputs of this gate unknown?
+  bool anyUnknown = (find(in.begin(), in.end(), LOGIC_X) != in.end());
+
+  int anyD    = find(in.begin(), in.end(), LOGIC_D)    != in.end();
+  int anyDBar = find(in.begin(), in.end(), LOGIC_DBAR) != in.end();
+
+
+  // if any input is c or we have both D and D', then return c^i
+  if ((anyC) || (anyD && anyDBar))
+    return (i) ? oldLogicNot(c) : c;
+  
+  // else if any input is unknown, return unknown
+  else if (anyUnknown)
+    return LOGIC_X;
+
+  // else if any input is D, return D^i
+  else if (anyD)
+    return (i) ? LOGIC_DBAR : LOGIC_D;
+
+  // else if any input is D', return D'^i
+  else if (anyDBar)
+    return (i) ? LOGIC_D : LOGIC_DBAR;
+
+  // else return ~(c^i)
+  else
+    return oldLogicNot((i) ? oldLogicNot(c) : c);
+}
+
+/** @brief Evaluate an XOR or XNOR gate.
+ * \param in The logic value's of this gate's inputs.
+ * \param inv The inverting value for this gate (e.g. i==0 for XOR and i==1 for XNOR)
+ * \returns The logical value produced by this gate (not including a possible fault on this gate).
+ */
+char oldEvalXORGate(vector<char> in, int inv) {
+
+  // if any unknowns, return unknown
+  bool anyUnknown = (find(in.begin(), in.end(), LOGIC_X) != in.end());
+  if (anyUnknown)
+    return LOGIC_X;
+
+  // Otherwise, let's count the numbers of ones and zeros for faulty and fault-free circuits.
+  // This is not required for your project, but this will with with XOR and XNOR with > 2 inputs.
+  int onesFaultFree = 0;
+  int onesFaulty = 0;
+
+  for (int i=0; i<in.size(); i++) {
+    switch(in[i]) {
+    case LOGIC_ZERO: {break;}
+    case LOGIC_ONE: {onesFaultFree++; onesFaulty++; break;}
+    case LOGIC_D: {onesFaultFree++; break;}
+    case LOGIC_DBAR: {onesFaulty++; break;}
+    default: {cout << "ERROR: Do not know how to process logic value " << in[i] << " in Gate::EvalXORGate()" << endl; return LOGIC_X;}
+    }
+  }
+  
+  int XORVal;
+
+  if ((onesFaultFree%2 == 0) && (onesFaulty%2 ==0))
+    XORVal = LOGIC_ZERO;
+  else if ((onesFaultFree%2 == 1) && (onesFaulty%2 ==1))
+    XORVal = LOGIC_ONE;
+  else if ((onesFaultFree%2 == 1) && (onesFaulty%2 ==0))
+    XORVal = LOGIC_D;
+  else
+    XORVal = LOGIC_DBAR;
+
+  return (inv) ? oldLogicNot(XORVal) : XORVal;
+
+}
+
+
+/** @brief Perform a logical NOT operation on a logical value using the LOGIC_* macros
+ */
+int oldLogicNot(int logicVal) {
+  if (logicVal == LOGIC_ONE)
+    return LOGIC_ZERO;
+  if (logicVal == LOGIC_ZERO)
+    return LOGIC_ONE;
+  if (logicVal == LOGIC_D)
+    return LOGIC_DBAR;
+  if (logicVal == LOGIC_DBAR)
+    return LOGIC_D;
+  if (logicVal == LOGIC_X)
+    return LOGIC_X;
+      
+  cout << "ERROR: Do not know how to invert " << logicVal << " in oldLogicNot(int logicVal)" << endl;
+  return LOGIC_UNSET;
+}
+
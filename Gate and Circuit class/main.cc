@@ -35,8 +35,8 @@
 #include <queue>
 #include <time.h>
 #include <stdio.h>
-#include "parse_bench.tab.h"
 #include "ClassCircuit.h"
+#include "ClassBenchParser.h"
 #include "ClassGate.h"
 #include <limits>
 #include <stdlib.h>
@@ -44,14 +44,8 @@
 
 using namespace std;
 
-/**  @brief Just for the parser. Don't touch. */
-extern "C" int yyparse();
-
-/**  Input file for parser. Don't touch. */
-extern FILE *yyin;
-
-/** Our circuit. We declare this external so the parser can use it more easily. */
-extern Circuit* myCircuit;
+/** Our circuit. */
+Circuit* myCircuit;
 
 //--------------------------
 // Helper functions
@@ -113,17 +107,17 @@ int main(int argc, char* argv[]) {
     return 1;
   }
   
-  // Parse the bench file and initialize the circuit. (Using C style for our parser.)
-  FILE *benchFile = fopen(argv[1], "r");
-  if (benchFile == NULL) {
-    cout << "ERROR: Cannot read file " << argv[1] << " for input" << endl;
+  // Parse the bench file and initialize the circuit.
+  BenchParser parser;
+  myCircuit = parser.parse(argv[1]);
+  if (myCircuit == NULL) {
+    cout << "ERROR: " << parser.getError() << endl;
     return 1;
   }
-  yyin=benchFile;
-  yyparse();
-  fclose(benchFile);
 
   myCircuit->setupCircuit(); 
+  // this simulator runs on the Gate objects rather than the compiled form
+  myCircuit->buildGates();
   cout << endl;
 
   // Setup the output text file
@@ -0,0 +1,4 @@
+// expect error: 3: constant 1'b0 is not supported
+module top (input a, output y);
+  assign y = 1'b0;
+endmodule
@@ -0,0 +1,6 @@
+// expect error: 5: signal y is driven twice
+module top (input a, b, output y);
+  wire y;
+  and (y, a, b);
+  or (y, a, b);
+endmodule
@@ -0,0 +1,7 @@
+// expect error: 6: unsupported statement or module instance 'half_adder'
+module top (a, b, s);
+  input a, b;
+  output s;
+  // only gate primitives are supported: the netlist must be flat
+  half_adder u1 (.a(a), .b(b), .s(s));
+endmodule
@@ -0,0 +1,5 @@
+// expect error: 4: signal w is used but never driven
+module top (input a, output y);
+  wire w;
+  and (y, a, w);
+endmodule
@@ -0,0 +1,5 @@
+// expect error: 4: assignment of 2 bits to 3 bits
+module top (input [1:0] a, output [2:0] y);
+  // a bus is assigned bit for bit, so the widths must match
+  assign y = a;
+endmodule
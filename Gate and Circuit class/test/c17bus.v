@@ -0,0 +1,16 @@
+// c17 (see c17.bench) with its inputs and outputs on buses: in[4:0] is {1, 2, 3, 6, 7} and
+// out[1:0] is {22, 23}. Stem 16 reaches its two gates through a two-output buf, and the
+// outputs are driven by a concatenation. c17bus.fault is c17.fault under these names, so
+// check.sh checks the results against c17.refout.
+module c17bus (input [4:0] in, output [1:0] out);
+  wire [1:0] n;        // {11, 10}
+  wire \16 , \19 , n16a, n16b;
+  wire [0:1] po;       // {22, 23}
+
+  nand g10 (n[0], in[4], in[2]), g11 (n[1], in[2], in[1]);
+  nand #1 g16 (\16 , in[3], n[1]);
+  nand (\19 , n[1], in[0]);
+  buf (n16a, n16b, \16 );
+  nand g22 (po[0], n[0], n16a), g23 (po[1], n16b, \19 );
+  assign out = {po[0], po[1]};
+endmodule
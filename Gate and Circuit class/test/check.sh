@@ -0,0 +1,106 @@
+#!/bin/sh
+# Runs the ATPG on the test circuits in each mode below, and checks every output with
+# checktests (see CheckTests.cc): each test must detect its fault, and the untestable faults
+# must match the reference output. The tests themselves may differ from the reference.
+#
+# Usage, from "Gate and Circuit class": sh test/check.sh [atpg] [checktests]
+# ("make check" builds both and runs this.) Exits with 1 if any check fails.
+
+ATPG=${1:-./podem}
+CHECK=${2:-./checktests}
+OUT=${TMPDIR:-/tmp}/atpg-check.$$
+mkdir -p $OUT
+failed=0
+
+# Modes, one per line. @ is replaced by a file name for the case being run.
+MODES="
+--no-fault-dropping
+--threads 4
+--pipeline --threads 3
+--sat-fallback 20
+--portfolio 20
+--learn
+--dual-rail
+--pipeline --threads 2 --dual-rail
+--dynamic-compaction
+--random-phase
+--save-compiled @.cnet
+--load-compiled @.cnet
+--static-compaction @.patterns"
+
+# run NAME BENCH FAULTS REFOUT MODE: run one case and check its output
+run() {
+  name=$1; bench=$2; faults=$3; ref=$4; opts=`echo "$5" | sed "s|@|$OUT/$name|g"`
+  if ! $ATPG test/$bench $OUT/$name.out test/$faults $opts > $OUT/$name.log 2>&1; then
+    echo "$name $opts: the ATPG failed (see $OUT/$name.log)"
+    failed=1
+    return
+  fi
+  patterns=""
+  case "$opts" in *--static-compaction*) patterns="--patterns $OUT/$name.patterns" ;; esac
+  printf "%s %s: " "$name" "$5"
+  $CHECK test/$bench test/$faults $OUT/$name.out test/$ref $patterns | tail -1
+  if ! $CHECK test/$bench test/$faults $OUT/$name.out test/$ref $patterns > /dev/null; then
+    $CHECK test/$bench test/$faults $OUT/$name.out test/$ref $patterns | head -5
+    failed=1
+  fi
+}
+
+echo "$MODES" | while read mode; do
+  for t in c17 ex1 ex2 target target2; do
+    run $t $t.bench $t.fault $t.refout "$mode"
+  done
+  # c17 again, as a Verilog netlist with buses (its faults are c17's, renamed)
+  run c17bus c17bus.v c17bus.fault c17.refout "$mode"
+  for s in small med; do
+    run c432.$s c432.bench c432.${s}fault c432.${s}refout "$mode"
+  done
+  # the big fault list is only quick when hard faults go to the SAT engine
+  case "$mode" in *--sat-fallback*|*--portfolio*)
+    run c432.big c432.bench c432.bigfault c432.bigrefout "$mode" ;;
+  esac
+  [ $failed = 0 ] || exit 1
+done
+failed=$?
+
+# the generated fault list, written out and checked against
+for t in c17 ex2 c432; do
+  mode="--dominance --write-faults $OUT/$t.faults"
+  if $ATPG test/$t.bench $OUT/$t.gen.out $mode > $OUT/$t.gen.log 2>&1; then
+    printf "%s (generated faults): " "$t"
+    $CHECK test/$t.bench $OUT/$t.faults $OUT/$t.gen.out | tail -1
+    $CHECK test/$t.bench $OUT/$t.faults $OUT/$t.gen.out > /dev/null || failed=1
+  else
+    echo "$t $mode: the ATPG failed"
+    failed=1
+  fi
+done
+
+# the Verilog c17 must give the same tests as c17.bench
+$ATPG test/c17.bench $OUT/c17.out test/c17.fault > /dev/null 2>&1
+$ATPG test/c17bus.v $OUT/c17bus.out test/c17bus.fault > /dev/null 2>&1
+if cmp -s $OUT/c17.out $OUT/c17bus.out; then
+  echo "c17bus.v: same tests as c17.bench: ok"
+else
+  echo "c17bus.v: the tests differ from those for c17.bench"
+  failed=1
+fi
+
+# netlists the Verilog reader must refuse, each with the error on its first line
+for f in test/bad_*.v; do
+  expected="$f:`sed -n '1s|^// expect error: ||p' $f`"
+  if $ATPG $f $OUT/bad.out test/c17.fault > $OUT/bad.log 2>&1; then
+    echo "$f: accepted, but should fail with: $expected"
+    failed=1
+  elif grep -qF "$expected" $OUT/bad.log; then
+    echo "$f: refused: ok"
+  else
+    echo "$f: should fail with: $expected"
+    cat $OUT/bad.log
+    failed=1
+  fi
+done
+
+rm -rf $OUT
+if [ $failed = 0 ]; then echo "All checks passed"; else echo "Some checks FAILED"; fi
+exit $failed
@@ -27,6 +27,9 @@
 // A quick way to figure out how long it takes to run something in
 // Linux is:
 //   time ./atpg ... type other params...
+//
+// The simulation and PODEM functions now live in the AtpgEngine class
+// (Gate and Circuit class/ClassAtpgEngine.cc); this file is the driver.
 
 
 #include <iostream>
@@ -35,66 +38,195 @@
 #include <queue>
 #include <time.h>
 #include <stdio.h>
-#include "parse_bench.tab.h"
 #include "ClassCircuit.h"
+#include "ClassBenchParser.h"
+#include "ClassVerilogParser.h"
 #include "ClassGate.h"
+#include "ClassAtpgEngine.h"
+#include "ClassFaultSim.h"
+#include "ClassWorkQueue.h"
+#include "ClassFaultList.h"
+#include "ClassLfsr.h"
+#include "ClassTestCompactor.h"
+#include "ClassImplicationTable.h"
 #include <limits>
 #include <stdlib.h>
 #include <time.h>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <iomanip>
 
 using namespace std;
 
-/**  @brief Just for the parser. Don't touch. */
-extern "C" int yyparse();
-
-/**  Input file for parser. Don't touch. */
-extern FILE *yyin;
-
-/** Our circuit. We declare this external so the parser can use it more easily. */
-extern Circuit* myCircuit;
-
 //--------------------------
 // Helper functions
 void printUsage();
 vector<char> constructInputLine(string line);
-bool checkTest(Circuit* myCircuit);
+bool checkTest(AtpgEngine &engine, const Circuit* myCircuit);
 string printPIValue(char v);
 //--------------------------
 
-//----------------------------
-// Functions for logic simulation
-void simFullCircuit(Circuit* myCircuit);
-void simGateRecursive(Gate* g);
-void eventDrivenSim(Circuit* myCircuit, queue<Gate*> q);
-char simGate(Gate* g);
-char evalGate(vector<char> in, int c, int i);
-char EvalXORGate(vector<char> in, int inv);
-int LogicNot(int logicVal);
-void setValueCheckFault(Gate* g, char gateValue);
-//-----------------------------
-
-//----------------------------
-// Functions for PODEM:
-bool podemRecursion(Circuit* myCircuit);
-bool getObjective(Gate* &g, char &v, Circuit* myCircuit);
-void updateDFrontier(Circuit* myCircuit);
-void backtrace(Gate* &pi, char &piVal, Gate* objGate, char objVal, Circuit* myCircuit);
-
 //--------------------------
+// Functions for running PODEM over the fault list
+struct FaultResult;
+FaultResult runPodem(AtpgEngine &engine, int faultLocation, char faultType, Circuit* myCircuit);
+int raceEngines(AtpgEngine &engine, int faultLocation, char faultType, const Circuit* myCircuit, int &winner);
+void podemWorker(int w, WorkQueue* queue, const FaultSim* faultSim, Circuit* myCircuit);
+string dropDetectedFaults(FaultSim &faultSim, const string &cube);
+string fillCube(const string &cube);
+string compactTest(AtpgEngine &engine, const string &cube, int primary, const FaultSim* faultSim, const Circuit* myCircuit);
+void randomPhase(FaultSim &faultSim, const Circuit* myCircuit, vector<string> &detectingTest);
+void runPipeline(FaultSim &faultSim, Circuit* myCircuit, vector<string> &detectingTest);
+void pipelineGenerator(int w, WorkQueue* queue, const FaultSim* faultSim, Circuit* myCircuit);
+void pipelineFaultSim(FaultSim* faultSim, vector<string>* detectingTest);
+int staticCompaction(FaultSim &faultSim, const vector<string> &tests, const Circuit* myCircuit);
+//--------------------------
+
+// Which engine decided a fault in portfolio mode (see raceEngines())
+#define RACE_NONE     0   // the fault was not raced (the short PODEM run decided it)
+#define RACE_PODEM    1   // PODEM finished first
+#define RACE_SAT      2   // the SAT engine finished first
+#define RACE_NEITHER  3   // both gave up
+
+// FaultResult::res of a fault the pipeline never ran PODEM on (a test had already detected it)
+#define PODEM_SKIPPED -1
 
+/** @brief What PODEM produced for one fault (see runPodem()). */
+struct FaultResult {
+  int res;          // PODEM_TEST_FOUND, PODEM_NO_TEST or PODEM_ABORTED (or PODEM_SKIPPED)
+  string test;      // the test, as printed to the output file (if res == PODEM_TEST_FOUND)
+  long backtracks;  // the number of backtracks PODEM made
+  bool sat;         // true if the SAT engine decided the fault (see --sat-fallback)
+  int race;         // in portfolio mode, which engine won (RACE_*)
+};
 
 ///////////////////////////////////////////////////////////
 // Global variables
-// These are made global to make your life slightly easier.
+// The PODEM search state lives in the AtpgEngine (see ClassAtpgEngine.cc);
+// these are only the driver's options.
+
+/** Global variable: the number of backtracks allowed per fault before PODEM aborts (-1: no limit). */
+long backtrackLimit = -1;
+
+/** Global variable: the number of seconds allowed per fault before PODEM aborts (-1: no limit). */
+double timeLimit = -1;
+
+/** Global variable: if true, each test PODEM finds is fault simulated, and the faults it
+ *  detects are dropped instead of being given to PODEM. */
+bool faultDropping = true;
+
+/** Global variable: source of the values given to X inputs before fault simulation
+ *  (fixed seed, so runs are repeatable). */
+mt19937 fillGenerator(1);
+
+/** Global variable: if true, the generated fault list is also collapsed by dominance. */
+bool dominanceCollapsing = false;
+
+/** Global variable: if not empty, the generated fault list is written to this file (in fault file format). */
+string faultListFile;
+
+/** Global variable: if true, fault simulate random patterns before running PODEM (see randomPhase()). */
+bool randomPatterns = false;
+
+/** Global variable: the random phase stops once a block of 64 patterns detects less than
+ *  this percentage of the fault list. */
+double randomCutoff = 0.1;
+
+// Seed of the LFSR that generates the random patterns
+#define RANDOM_SEED 0x5EED5EED5EED5EEDULL
+
+/** Global variable: if true, each test PODEM finds is extended to detect more faults (see compactTest()). */
+bool dynamicCompaction = false;
+
+/** Global variable: the number of backtracks PODEM may make on each secondary fault. */
+long secondaryBacktracks = 10;
+
+/** Global variable: if not empty, the tests are compacted (see staticCompaction()) and written to this file. */
+string compactedPatternFile;
+
+/** Global variable: if true, PODEM evaluates gates in the dual-rail encoding, and tests are fault
+ *  simulated as cubes, keeping their X's (see FaultSim::simulateCubes()). */
+bool dualRail = false;
+
+// Seed of the LFSR that fills the X inputs of the compacted patterns
+#define COMPACTION_SEED 0xC0FFEE1234567ULL
+
+/** Global variable: if true, faults PODEM gives up on are given to the SAT engine (see SatAtpg). */
+bool satFallback = false;
+
+/** Global variable: if true, faults PODEM cannot settle within satDecisionLimit decisions are
+ *  given to PODEM and the SAT engine at the same time, on two threads (see raceEngines()). */
+bool portfolio = false;
+
+/** Global variable: with satFallback or portfolio, PODEM gives up on a fault after this many decisions. */
+long satDecisionLimit = -1;
+
+/** Global variable: solver conflicts allowed per fault (-1: no limit). */
+long satConflictLimit = -1;
+
+/** Global variable: if true, run static learning before test generation (see ImplicationTable::learn()). */
+bool staticLearning = false;
+
+/** Global variable: if not empty, the learned implications are loaded from this file instead. */
+string learnedLoadFile;
+
+/** Global variable: if not empty, the learned implications are saved to this file. */
+string learnedSaveFile;
 
-/** Global variable: a vector of Gate pointers for storing the D-Frontier. */
-vector<Gate*> dFrontier;
+/** Global variable: if not empty, the circuit is loaded from this compiled file instead of being parsed. */
+string compiledLoadFile;
 
-/** Global variable: holds a pointer to the gate with stuck-at fault on its output location. */
-Gate* faultLocation;     
+/** Global variable: if not empty, the compiled circuit is saved to this file. */
+string compiledSaveFile;
 
-/** Global variable: holds the logic value you will need to activate the stuck-at fault. */
-char faultActivationVal;
+/** Global variable: the learned implications used by every engine (NULL if there are none). */
+const ImplicationTable* learnedTable = NULL;
+
+/** Global variable: the number of threads running PODEM. */
+int numThreads = 1;
+
+// With more than one thread, worker threads run PODEM on faults ahead of main(),
+// which uses their results in fault-file order. These are shared between them,
+// and guarded by resultMutex.
+
+/** Global variable: guards faultResults, resultReady and faultDropped. */
+mutex resultMutex;
+
+/** Global variable: signalled each time a worker stores a result. */
+condition_variable resultReadyCond;
+
+/** Global variable: the result of PODEM for each fault, valid once resultReady[f] is 1. */
+vector<FaultResult> faultResults;
+
+/** Global variable: resultReady[f] is 1 once a worker has stored faultResults[f] (or skipped f). */
+vector<char> resultReady;
+
+/** Global variable: faultDropped[f] is 1 once main() has dropped fault f; workers skip it. */
+vector<char> faultDropped;
+
+/** Global variable: if true, use the pipeline (see runPipeline()) instead of using results in fault-file order. */
+bool pipeline = false;
+
+/** Global variable: in pipeline mode, faultStatus[f] becomes 1 once fault simulation has detected
+ *  fault f. It is written by the fault simulation thread and read by the PODEM threads without a lock. */
+vector< atomic<char> > faultStatus;
+
+/** Global variable: in pipeline mode, guards cubeQueue and numGeneratorsRunning. */
+mutex cubeMutex;
+
+/** Global variable: signalled when a cube is queued or a PODEM thread finishes. */
+condition_variable cubeCond;
+
+/** Global variable: in pipeline mode, tests found by PODEM and not fault simulated yet. */
+deque<string> cubeQueue;
+
+/** Global variable: in pipeline mode, the number of PODEM threads still running. */
+int numGeneratorsRunning;
 
 ///////////////////////////////////////////////////////////
 
@@ -109,22 +241,150 @@ char faultActivationVal;
 int main(int argc, char* argv[]) {
 
   // Check the command line input and usage
-  if (argc != 4) {
+  if (argc < 3) {
     printUsage();    
     return 1;
   }
+
+  // The fault file is optional: without it, we generate the fault list.
+  string faultFileName;
+  int firstOption = 3;
+  if ((argc > 3) && (string(argv[3]).compare(0, 2, "--") != 0)) {
+    faultFileName = argv[3];
+    firstOption = 4;
+  }
+
+  for (int i=firstOption; i<argc; i++) {
+    string opt = argv[i];
+    if ((opt == "--backtrack-limit") && (i+1 < argc))
+      backtrackLimit = atol(argv[++i]);
+    else if ((opt == "--time-limit") && (i+1 < argc))
+      timeLimit = atof(argv[++i]);
+    else if (opt == "--no-fault-dropping")
+      faultDropping = false;
+    else if ((opt == "--threads") && (i+1 < argc) && (atoi(argv[i+1]) > 0))
+      numThreads = atoi(argv[++i]);
+    else if (opt == "--pipeline")
+      pipeline = true;
+    else if (opt == "--dominance")
+      dominanceCollapsing = true;
+    else if ((opt == "--write-faults") && (i+1 < argc))
+      faultListFile = argv[++i];
+    else if (opt == "--dynamic-compaction")
+      dynamicCompaction = true;
+    else if ((opt == "--secondary-backtracks") && (i+1 < argc))
+      secondaryBacktracks = atol(argv[++i]);
+    else if (opt == "--random-phase")
+      randomPatterns = true;
+    else if ((opt == "--random-cutoff") && (i+1 < argc) && (atof(argv[i+1]) > 0))
+      randomCutoff = atof(argv[++i]);
+    else if ((opt == "--sat-fallback") && (i+1 < argc)) {
+      satFallback = true;
+      satDecisionLimit = atol(argv[++i]);
+    }
+    else if ((opt == "--portfolio") && (i+1 < argc)) {
+      portfolio = true;
+      satDecisionLimit = atol(argv[++i]);
+    }
+    else if ((opt == "--sat-conflict-limit") && (i+1 < argc))
+      satConflictLimit = atol(argv[++i]);
+    else if (opt == "--learn")
+      staticLearning = true;
+    else if ((opt == "--load-learned") && (i+1 < argc))
+      learnedLoadFile = argv[++i];
+    else if ((opt == "--save-learned") && (i+1 < argc))
+      learnedSaveFile = argv[++i];
+    else if ((opt == "--static-compaction") && (i+1 < argc))
+      compactedPatternFile = argv[++i];
+    else if (opt == "--dual-rail")
+      dualRail = true;
+    else if ((opt == "--load-compiled") && (i+1 < argc))
+      compiledLoadFile = argv[++i];
+    else if ((opt == "--save-compiled") && (i+1 < argc))
+      compiledSaveFile = argv[++i];
+    else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  // The pipeline and the random phase exist to drop faults.
+  if ((pipeline || randomPatterns) && !faultDropping) {
+    printUsage();
+    return 1;
+  }
+
+  // A fault is either handed on to the SAT engine or raced against it.
+  if (satFallback && portfolio) {
+    printUsage();
+    return 1;
+  }
   
-  // Parse the bench file and initialize the circuit. (Using C style for our parser.)
-  FILE *benchFile = fopen(argv[1], "r");
-  if (benchFile == NULL) {
-    cout << "ERROR: Cannot read file " << argv[1] << " for input" << endl;
+  // Load the compiled circuit, or parse the bench file and initialize the circuit.
+  Circuit* myCircuit;
+  if (!compiledLoadFile.empty()) {
+    string error;
+    myCircuit = new Circuit;
+    if (!myCircuit->loadCompiled(compiledLoadFile, argv[1], error)) {
+      cout << "ERROR: " << error << endl;
+      return 1;
+    }
+  }
+  else {
+    // A .v file is a structural Verilog netlist; anything else is read as .bench.
+    string circuitFile = argv[1], error;
+    if ((circuitFile.size() > 2) && (circuitFile.compare(circuitFile.size()-2, 2, ".v") == 0)) {
+      VerilogParser parser;
+      myCircuit = parser.parse(circuitFile);
+      error = parser.getError();
+    }
+    else {
+      BenchParser parser;
+      myCircuit = parser.parse(circuitFile);
+      error = parser.getError();
+    }
+    if (myCircuit == NULL) {
+      cout << "ERROR: " << error << endl;
+      return 1;
+    }
+
+    myCircuit->setupCircuit();
+  }
+
+  if (!compiledSaveFile.empty() && !myCircuit->saveCompiled(compiledSaveFile, argv[1], true)) {
+    cout << "ERROR: Cannot open file " << compiledSaveFile << " for output" << endl;
     return 1;
   }
-  yyin=benchFile;
-  yyparse();
-  fclose(benchFile);
 
-  myCircuit->setupCircuit();
+  // Learn (or load) the indirect implications, once for all faults.
+  ImplicationTable implications(myCircuit);
+  if (!learnedLoadFile.empty()) {
+    if (!implications.load(learnedLoadFile)) {
+      cout << "ERROR: Cannot load learned implications for this circuit from " << learnedLoadFile << endl;
+      return 1;
+    }
+    learnedTable = &implications;
+    cout << "Loaded " << implications.getNumberLearned() << " learned implications" << endl;
+  }
+  else if (staticLearning || !learnedSaveFile.empty()) {
+    chrono::steady_clock::time_point learnStart = chrono::steady_clock::now();
+    implications.learn();
+    chrono::duration<double> learnTime = chrono::steady_clock::now() - learnStart;
+    learnedTable = &implications;
+    cout << "Static learning: " << implications.getNumberLearned() << " implications in " << learnTime.count() << " s" << endl;
+  }
+  if (!learnedSaveFile.empty() && !implications.save(learnedSaveFile)) {
+    cout << "ERROR: Cannot open file " << learnedSaveFile << " for output" << endl;
+    return 1;
+  }
+
+  AtpgEngine engine(myCircuit);
+  engine.setBacktrackLimit(backtrackLimit);
+  engine.setTimeLimit(timeLimit);
+  if (satFallback)
+    engine.setSatFallback(satDecisionLimit, satConflictLimit);
+  engine.setImplicationTable(learnedTable);
+  engine.setDualRail(dualRail);
 
   cout << endl;
    
@@ -138,87 +398,199 @@ int main(int argc, char* argv[]) {
     return 1;
   }
     
-  // Open the fault file.
-  ifstream faultStream;
-  string faultLocStr;
-  faultStream.open(argv[3]);
-  if (!faultStream.is_open()) {
-    cout << "ERROR: Cannot open fault file " << argv[3] << " for input" << endl;
-    return 1;
+  // Read the whole fault list first, so the fault simulator can drop
+  // faults before PODEM reaches them.
+  FaultSim faultSim(myCircuit);
+  if (!faultFileName.empty()) {
+    ifstream faultStream;
+    string faultLocStr;
+    faultStream.open(faultFileName.c_str());
+    if (!faultStream.is_open()) {
+      cout << "ERROR: Cannot open fault file " << faultFileName << " for input" << endl;
+      return 1;
+    }
+
+    while(getline(faultStream, faultLocStr)) {
+      string faultTypeStr;
+
+      if (!(getline(faultStream, faultTypeStr))) {
+        break;
+      }
+
+      int g = myCircuit->findGateIndexByName(faultLocStr);
+      if (g < 0) {
+        cout << "ERROR: Cannot find fault location " << faultLocStr << " in circuit" << endl;
+        return 1;
+      }
+      faultSim.addFault(g, atoi(faultTypeStr.c_str()));
+    }
+
+    faultStream.close();
   }
-  
 
-  // For each line in our fault file...
-  while(getline(faultStream, faultLocStr)) {
+  // Or generate it from the circuit.
+  else {
+    FaultList faultList(myCircuit);
+    faultList.build(dominanceCollapsing);
+    cout << "Generated " << faultList.getNumberFaults() << " collapsed faults (" << faultList.getNumberUncollapsed() << " before collapsing)" << endl;
+
+    ofstream faultListStream;
+    if (!faultListFile.empty()) {
+      faultListStream.open(faultListFile.c_str());
+      if (!faultListStream.is_open()) {
+        cout << "ERROR: Cannot open file " << faultListFile << " for output" << endl;
+        return 1;
+      }
+    }
 
-    // Clear the old fault
-    myCircuit->clearFaults();
-      
-    string faultTypeStr;
-      
-    if (!(getline(faultStream, faultTypeStr))) {
-      break;
+    for (int f=0; f<faultList.getNumberFaults(); f++) {
+      faultSim.addFault(faultList.getFaultGate(f), faultList.getFaultType(f));
+      if (faultListStream.is_open())
+        faultListStream << myCircuit->getGateName(faultList.getFaultGate(f)) << endl << (int)faultList.getFaultType(f) << endl;
+    }
+    faultListStream.close();
+  }
+
+  // detectingTest[f] is the (fully specified) test that detected fault f in fault simulation
+  int numFaults = faultSim.getNumberFaults();
+  vector<string> detectingTest(numFaults);
+
+  // outputTest[f] is the test written to the output file for fault f (empty if there is none)
+  vector<string> outputTest(numFaults);
+  int numUntestable = 0, numAborted = 0;
+  vector<int> raceWins(4, 0);
+
+  // Detect the easy faults with random patterns first.
+  if (randomPatterns)
+    randomPhase(faultSim, myCircuit, detectingTest);
+
+  // Start the worker threads. Fault f is first queued for worker f % numThreads;
+  // a worker that runs out of faults steals from the others.
+  WorkQueue queue(numThreads);
+  vector<thread> workers;
+  if (pipeline)
+    runPipeline(faultSim, myCircuit, detectingTest);
+  else if (numThreads > 1) {
+    faultResults.resize(numFaults);
+    resultReady.assign(numFaults, 0);
+    faultDropped.assign(numFaults, 0);
+    for (int f=0; f<numFaults; f++)
+      faultDropped[f] = faultSim.isDetected(f);
+    for (int f=0; f<numFaults; f++)
+      queue.push(f % numThreads, f);
+    for (int w=0; w<numThreads; w++)
+      workers.push_back(thread(podemWorker, w, &queue, &faultSim, myCircuit));
+  }
+
+  // Results are used (printed, fault simulated, and used to drop faults)
+  // strictly in fault-file order, so the output does not depend on the
+  // number of threads.
+  // For each fault in our fault file...
+  for (int f=0; f<numFaults; f++) {
+
+    char faultType = faultSim.getFaultType(f);
+    int faultLocation = faultSim.getFaultGate(f);
+
+    // If an earlier test already detects this fault, reuse it. In the pipeline, fault simulation
+    // also credits each fault with its own test, so a fault PODEM found a test for is reported as such.
+    bool podemFound = pipeline && (faultResults[f].res == PODEM_TEST_FOUND);
+    if (faultDropping && faultSim.isDetected(f) && !podemFound) {
+      outputStream << detectingTest[f] << endl;
+      outputTest[f] = detectingTest[f];
+      cout << "Fault = " << myCircuit->getGateName(faultLocation) << " / " << (int)(faultType) << "; detected by fault simulation" << endl;
+      continue;
     }
-      
-    char faultType = atoi(faultTypeStr.c_str());
-      
-    // set up the fault we are trying to detect
-    faultLocation = myCircuit->findGateByName(faultLocStr);      
-    faultLocation->set_faultType(faultType);      
-    faultActivationVal = (faultType == FAULT_SA0) ? LOGIC_ONE : LOGIC_ZERO;
-      
-    // set all gate values to X
-    for (int i=0; i < myCircuit->getNumberGates(); i++) {
-      myCircuit->getGate(i)->setValue(LOGIC_X);
+
+    // call PODEM, or wait for the worker that does
+    FaultResult r;
+    if ((numThreads > 1) || pipeline) {
+      unique_lock<mutex> lock(resultMutex);
+      while (!resultReady[f])
+        resultReadyCond.wait(lock);
+      r = faultResults[f];
     }
+    else
+      r = runPodem(engine, faultLocation, faultType, myCircuit);
+    int res = r.res;
 
-    // initialize the D frontier.
-    dFrontier.clear();
-      
-    // call PODEM recursion function
-    bool res = podemRecursion(myCircuit);
+    // Use the test's X inputs to detect more faults.
+    if ((res == PODEM_TEST_FOUND) && dynamicCompaction && !pipeline)
+      r.test = compactTest(engine, r.test, f, &faultSim, myCircuit);
 
     // If we succeed, print the test we found to the output file.
-    if (res == true) {
-      vector<Gate*> piGates = myCircuit->getPIGates();
-      for (int i=0; i < piGates.size(); i++)
-        outputStream << printPIValue(piGates[i]->getValue());
-      outputStream << endl;
+    if (res == PODEM_TEST_FOUND) {
+      outputStream << r.test << endl;
+      outputTest[f] = r.test;
+
+      // Fault simulate the test and drop the faults it detects (the pipeline already has).
+      if (faultDropping && !pipeline) {
+        string test = dropDetectedFaults(faultSim, r.test);
+        const vector<int>& dropped = faultSim.getLastDetected();
+        for (int i=0; i<dropped.size(); i++)
+          detectingTest[dropped[i]] = test;
+        faultSim.setDetected(f);
+
+        if (numThreads > 1) {
+          lock_guard<mutex> lock(resultMutex);
+          for (int i=0; i<dropped.size(); i++)
+            faultDropped[dropped[i]] = 1;
+        }
+      }
+    }
+
+    // If we gave up on the fault, say so; this is not a proof that it is untestable.
+    else if (res == PODEM_ABORTED) {
+      outputStream << "aborted" << endl;
+      numAborted++;
     }
 
     // If we failed to find a test, print a message to the output file
     else {
       outputStream << "none found" << endl;
-    }
-
-    // Lastly, you can use this to test that your PODEM-generated test
-    // correctly detects the already-set fault.
-    // Of course, this assumes that your simulation code is correct.
-
-    // Don't use this code when you are evaluating the runtime of your
-    // ATPG system because it will add extra time.
-    if (res == true) {
-      if (!checkTest(myCircuit)) {
-        cout << "ERROR: PODEM returned true, but generated test does not detect fault on PO." << endl;
-        myCircuit->printAllGates();
-        assert(false);
-      }
+      numUntestable++;
     }
 
     // Just printing to screen to let you monitor progress
-    cout << "Fault = " << faultLocation->get_outputName() << " / " << (int)(faultType) << ";";
-    if (res == true)
-      cout << " test found" << endl;
+    cout << "Fault = " << myCircuit->getGateName(faultLocation) << " / " << (int)(faultType) << ";";
+    if (res == PODEM_TEST_FOUND)
+      cout << " test found";
+    else if (res == PODEM_ABORTED)
+      cout << " aborted after " << r.backtracks << " backtracks";
     else
-      cout << " no test found" << endl;
+      cout << " no test found";
+    cout << (r.sat ? " (SAT)" : "");
+    if (r.race == RACE_PODEM)
+      cout << " (race won by PODEM)";
+    else if (r.race == RACE_SAT)
+      cout << " (race won by SAT)";
+    else if (r.race == RACE_NEITHER)
+      cout << " (PODEM and SAT both gave up)";
+    cout << endl;
+    raceWins[r.race]++;
     
   }
 
-  faultStream.close();
-  
-  // close the output and fault streams
+  for (int w=0; w<workers.size(); w++)
+    workers[w].join();
+
+  // close the output stream
   outputStream.close();
 
+  if (portfolio)
+    cout << "Portfolio: " << raceWins[RACE_PODEM] + raceWins[RACE_SAT] + raceWins[RACE_NEITHER]
+         << " faults raced, PODEM won " << raceWins[RACE_PODEM] << ", SAT won " << raceWins[RACE_SAT]
+         << ", both gave up on " << raceWins[RACE_NEITHER] << endl;
+
+  // Compact the tests and report the coverage of the compacted set.
+  if (!compactedPatternFile.empty()) {
+    int numDetected = staticCompaction(faultSim, outputTest, myCircuit);
+    if (numDetected < 0)
+      return 1;
+    cout << "Coverage: " << numDetected << " of " << numFaults << " faults detected ("
+         << fixed << setprecision(2) << (numFaults ? 100.0 * numDetected / numFaults : 100.0) << "%), "
+         << numUntestable << " untestable, " << numAborted << " aborted" << endl;
+  }
+
     
   return 0;
 }
@@ -236,13 +608,48 @@ int main(int argc, char* argv[]) {
  * You don't need to touch this.
  */
 void printUsage() {
-  cout << "Usage: ./atpg [bench_file] [output_loc] [fault_file]" << endl << endl;
-  cout << "   bench_file:    the target circuit in .bench format" << endl;
+  cout << "Usage: ./atpg [bench_file] [output_loc] [fault_file] [options]" << endl << endl;
+  cout << "   bench_file:    the target circuit in .bench format, or a flat structural Verilog" << endl;
+  cout << "                  netlist of gate primitives if its name ends in .v" << endl;
   cout << "   output_loc:    location for output file" << endl;
-  cout << "   fault_file:    faults to be considered" << endl;
+  cout << "   fault_file:    faults to be considered (optional)" << endl;
   cout << endl;
   cout << "   The system will generate a test pattern for each fault listed" << endl;
   cout << "   in fault_file and store the result in output_loc." << endl;
+  cout << "   Without fault_file, it generates a collapsed list of all stuck-at faults." << endl;
+  cout << endl;	
+  cout << "   Options:" << endl;
+  cout << "   --backtrack-limit N:  give up on a fault after N backtracks" << endl;
+  cout << "   --time-limit S:       give up on a fault after S seconds" << endl;
+  cout << "   --no-fault-dropping:  run PODEM on every fault, even if an earlier test detects it" << endl;
+  cout << "   --threads N:          run PODEM on N faults at a time (the output does not change," << endl;
+  cout << "                         unless --time-limit makes PODEM give up at different points)" << endl;
+  cout << "   --dominance:          collapse the generated fault list by dominance too" << endl;
+  cout << "   --write-faults F:     write the generated fault list to F, in fault_file format" << endl;
+  cout << "   --dynamic-compaction: after each test is found, use its X inputs to detect more faults" << endl;
+  cout << "   --secondary-backtracks N: backtracks allowed for each of those faults (default 10)" << endl;
+  cout << "   --random-phase:       detect what faults we can with random patterns before running PODEM" << endl;
+  cout << "   --random-cutoff P:    stop the random phase once 64 patterns detect less than P% of" << endl;
+  cout << "                         the faults (default 0.1)" << endl;
+  cout << "   --sat-fallback N:     after N decisions on a fault (or the backtrack or time limit)," << endl;
+  cout << "                         give it to a SAT solver instead of aborting" << endl;
+  cout << "   --portfolio N:        after N decisions on a fault, race PODEM against a SAT solver" << endl;
+  cout << "                         on two threads; the first to decide the fault wins" << endl;
+  cout << "   --sat-conflict-limit N: solver conflicts allowed per fault (default: no limit)" << endl;
+  cout << "   --learn:              learn indirect implications first, and use them in PODEM" << endl;
+  cout << "   --save-learned F:     save the learned implications to F (implies --learn)" << endl;
+  cout << "   --load-learned F:     load implications saved with --save-learned instead of learning" << endl;
+  cout << "   --static-compaction F: merge compatible tests, drop the ones reverse-order fault" << endl;
+  cout << "                         simulation finds unneeded, and write the patterns left to F" << endl;
+  cout << "   --dual-rail:          evaluate gates with dual-rail bitwise operations, and fault simulate" << endl;
+  cout << "                         the tests with their X's (only faults every fill detects are dropped)" << endl;
+  cout << "   --save-compiled F:    save the set-up circuit to F, a binary file --load-compiled can map" << endl;
+  cout << "   --load-compiled F:    load the circuit saved with --save-compiled instead of parsing the" << endl;
+  cout << "                         bench file (which is only checked to be unchanged since)" << endl;
+  cout << "   --pipeline:           run PODEM on N threads (see --threads) while another thread fault" << endl;
+  cout << "                         simulates their tests, 64 at a time, and drops faults. Faster with" << endl;
+  cout << "                         many threads, but which faults are dropped depends on timing." << endl;
+  cout << "   A fault PODEM gives up on is reported as \"aborted\" in output_loc." << endl;
   cout << endl;	
 }
 
@@ -288,7 +695,7 @@ vector<char> constructInputLine(string line) {
  * This function of course assumes that your simulation code 
  * is correct.
 */
-bool checkTest(Circuit* myCircuit) {
+bool checkTest(AtpgEngine &engine, const Circuit* myCircuit) {
 
   // To enable this function, just comment out return true; here,
   // and the function will run.
@@ -296,12 +703,12 @@ bool checkTest(Circuit* myCircuit) {
   // the system will not do the extra test after generating the vector.
   return true;
 
-  simFullCircuit(myCircuit);
+  engine.simFullCircuit();
 
   // look for D or D' on an output
-  vector<Gate*> poGates = myCircuit->getPOGates();
+  const vector<uint32_t>& poGates = myCircuit->getPOIndices();
   for (int i=0; i<poGates.size(); i++) {
-    char v = poGates[i]->getValue();
+    char v = engine.getValue(poGates[i]);
     if ((v == LOGIC_D) || (v == LOGIC_DBAR)) {
       return true;
     }
@@ -334,489 +741,450 @@ string printPIValue(char v) {
 // end of helper functions
 //////////////////////////////////////////////////////////////////////
 
-//////////////////////////////////////////////////////////////////////
-// Start of functions for circuit simulation.
-
+////////////////////////////////////////////////////////////////////////////
+// Place any new functions you add here, between these two bars.
 
 
-/** @brief Runs full circuit simulation
- *
- * Full-circuit simulation: set all non-PI gates to LOGIC_UNSET
- * and call the recursive simulate function on all PO gates.
- * Don't change this function unless you want to use your Project 2 code.
+/** @brief Run PODEM for one fault.
+ * @param engine The engine to use
+ * @param faultLocation The gate whose output is faulty
+ * @param faultType FAULT_SA0 or FAULT_SA1
+ * @param myCircuit The circuit
+ * @return The result, with the test (if any) as it is printed to the output file
  */
-void simFullCircuit(Circuit* myCircuit) {
-  for (int i=0; i<myCircuit->getNumberGates(); i++) {
-    Gate* g = myCircuit->getGate(i);
-    if (g->get_gateType() != GATE_PI)
-      g->setValue(LOGIC_UNSET);      
-  }  
-  vector<Gate*> circuitPOs = myCircuit->getPOGates();
-  for (int i=0; i < circuitPOs.size(); i++) {
-    simGateRecursive(circuitPOs[i]);
-  }
-}
-
+FaultResult runPodem(AtpgEngine &engine, int faultLocation, char faultType, Circuit* myCircuit) {
+  FaultResult r;
+  r.race = RACE_NONE;
+  if (portfolio)
+    r.res = raceEngines(engine, faultLocation, faultType, myCircuit, r.race);
+  else
+    r.res = engine.generateTest(faultLocation, faultType);
+  r.backtracks = engine.getNumBacktracks();
+  r.sat = engine.getSatUsed();
 
+  if (r.res == PODEM_TEST_FOUND) {
+    const vector<uint32_t>& piGates = myCircuit->getPIIndices();
+    for (int i=0; i < piGates.size(); i++)
+      r.test += printPIValue(engine.getValue(piGates[i]));
 
-// Recursive function to find and set the value on Gate* g.
-// This function calls simGate and setValueCheckFault. 
-// Don't change this function.
-/** @brief Recursive function to find and set the value on Gate* g.
- * \param g The gate to simulate.
- * This function prepares Gate* g to to be simulated by recursing
- * on its inputs (if needed).
- * 
- * Then it calls \a simGate(g) to calculate the new value.
- * 
- * Lastly, it will set the Gate's output value based on
- * the calculated value.
- * 
- * \note Do not change this function. 
- */
-void simGateRecursive(Gate* g) {
+    // Lastly, you can use this to test that your PODEM-generated test
+    // correctly detects the already-set fault.
+    // Of course, this assumes that your simulation code is correct.
 
-  // If this gate has an already-set value, you are done.
-  if (g->getValue() != LOGIC_UNSET)
-    return;
-  
-  // Recursively call this function on this gate's predecessors to
-  // ensure that their values are known.
-  vector<Gate*> pred = g->get_gateInputs();
-  for (int i=0; i<pred.size(); i++) {
-    simGateRecursive(pred[i]);
+    // Don't use this code when you are evaluating the runtime of your
+    // ATPG system because it will add extra time.
+    if (!checkTest(engine, myCircuit)) {
+      cout << "ERROR: PODEM returned true, but generated test does not detect fault on PO." << endl;
+      // (with the compiled accessors, which also work on a circuit from --load-compiled)
+      for (int i=0; i < myCircuit->getLevelOrder().size(); i++) {
+        char v = engine.getValue(i);
+        cout << myCircuit->getGateName(i) << " = " << ((v <= LOGIC_X) ? "01DBX"[(int)v] : 'U') << endl;
+      }
+      assert(false);
+    }
   }
-  
-  char gateValue = simGate(g);
-
-  // After I have calculated this gate's value, check to see if a fault changes it and set.
-  setValueCheckFault(g, gateValue);
+  return r;
 }
 
+/** @brief Portfolio mode: race PODEM against the SAT engine on one fault.
+ *
+ * PODEM first gets satDecisionLimit decisions on its own. If that does not settle the
+ * fault, that same search carries on (see AtpgEngine::resumeTest(); the usual backtrack and
+ * time limits still count from the start of the fault) on this thread while a SatAtpg
+ * runs on another. The first to find a test or prove the fault untestable wins and sets a
+ * stop flag, which the other checks regularly and gives up on.
+ * @param engine The engine to use; if SAT wins with a test, the test is put in it (see AtpgEngine::setTest())
+ * @param faultLocation The gate whose output is faulty
+ * @param faultType FAULT_SA0 or FAULT_SA1
+ * @param myCircuit The circuit
+ * @param winner Output: which engine won (RACE_*)
+ * @return PODEM_TEST_FOUND, PODEM_NO_TEST, or PODEM_ABORTED, as for AtpgEngine::generateTest()
+ */
+int raceEngines(AtpgEngine &engine, int faultLocation, char faultType, const Circuit* myCircuit, int &winner) {
+  winner = RACE_NONE;
+  engine.setDecisionLimit(satDecisionLimit);
+  int res = engine.generateTest(faultLocation, faultType);
+  engine.setDecisionLimit(-1);
+  if (res != PODEM_ABORTED)
+    return res;
+
+  atomic<bool> stop(false);
+  atomic<int> first(RACE_NONE);
+  SatAtpg sat(myCircuit);
+  sat.setConflictLimit(satConflictLimit);
+  sat.setStopFlag(&stop);
+  int satRes = SAT_UNKNOWN;
+  thread satThread([&]() {
+    satRes = sat.generateTest(faultLocation, faultType);
+    int none = RACE_NONE;
+    if ((satRes != SAT_UNKNOWN) && first.compare_exchange_strong(none, RACE_SAT))
+      stop = true;
+  });
+
+  engine.setStopFlag(&stop);
+  res = engine.resumeTest();
+  engine.setStopFlag(NULL);
+  int none = RACE_NONE;
+  if ((res != PODEM_ABORTED) && first.compare_exchange_strong(none, RACE_PODEM))
+    stop = true;
+  satThread.join();
+
+  winner = first;
+  if (winner == RACE_PODEM)
+    return res;
+  if (winner == RACE_SAT) {
+    if (satRes == SAT_UNSAT)
+      return PODEM_NO_TEST;
+    engine.setTest(faultLocation, faultType, sat.getTest());
+    return PODEM_TEST_FOUND;
+  }
+  winner = RACE_NEITHER;
+  return PODEM_ABORTED;
+}
 
-/** @brief Perform event-driven simulation.
- * \note You will write this function in Part 3. See psuedocode in its comments.
- * 
- * Please see the project handout for a description of what
- * we are doing here and why.
-
- * This function takes as input the Circuit* and a queue<Gate*>
- * indicating the remaining gates that need to be evaluated.
+/** @brief The body of worker thread w: run PODEM on faults from the queue until it is empty.
+ *
+ * Each worker has its own AtpgEngine; the circuit and fault list are only read.
+ * Faults that main() has already dropped are skipped.
  */
-void eventDrivenSim(Circuit* myCircuit, queue<Gate*> q) {
+void podemWorker(int w, WorkQueue* queue, const FaultSim* faultSim, Circuit* myCircuit) {
+  AtpgEngine engine(myCircuit);
+  engine.setBacktrackLimit(backtrackLimit);
+  engine.setTimeLimit(timeLimit);
+  if (satFallback)
+    engine.setSatFallback(satDecisionLimit, satConflictLimit);
+  engine.setImplicationTable(learnedTable);
+  engine.setDualRail(dualRail);
+
+  int f;
+  while (queue->pop(w, f)) {
+    bool skip;
+    {
+      lock_guard<mutex> lock(resultMutex);
+      skip = faultDropped[f];
+    }
 
-  // Basic idea: 
-  // - Keep a queue (input q) of gates whose output values may potentially change
-  // - while there are still gates in the queue: 
-  //      - Pop a gate from this queue. Store its currently-set output value.
-  //      - Based on the gate's inputs, calculate its new output value. Note that you don't
-  //        need to do this from scratch, you can use the simGate() function below.
-  //      - Check to see if the new gate output value differs from the old one. If it does
-  //        add its fanout gates on the queue  
+    FaultResult r;
+    if (!skip)
+      r = runPodem(engine, faultSim->getFaultGate(f), faultSim->getFaultType(f), myCircuit);
 
+    {
+      lock_guard<mutex> lock(resultMutex);
+      if (!skip)
+        faultResults[f] = r;
+      resultReady[f] = 1;
+    }
+    resultReadyCond.notify_all();
+  }
 }
 
-
-
-/** @brief Simulate the value of the given Gate.
- *
- * This is a gate simulation function -- it will simulate the gate g
- * with its current input values and return the output value.
- * This function does not deal with the fault. (That comes later.)
- * \note You do not need to change this function.
+/** @brief Fault simulate a test PODEM found, and drop the faults it detects.
  *
+ * The X inputs of the test are filled with random values, then the
+ * filled test is simulated against every fault \a faultSim has not detected yet.
+ * The faults it detects are marked detected and listed by FaultSim::getLastDetected().
+ * With --dual-rail, the test is simulated with its X's instead, and only the faults it
+ * detects however they are filled are dropped.
+ * @param faultSim The fault simulator holding the fault list
+ * @param cube The test, as printed to the output file (one 0, 1 or X per PI)
+ * @return The filled test (with --dual-rail, the cube itself), as it would be printed to the output file
  */
-char simGate(Gate* g) {
-  // For convenience, create a vector of the values of this
-  // gate's inputs.
-  vector<Gate*> pred = g->get_gateInputs();
-  vector<char> inputVals;   
-  for (int i=0; i<pred.size(); i++) {
-    inputVals.push_back(pred[i]->getValue());      
+string dropDetectedFaults(FaultSim &faultSim, const string &cube) {
+  if (dualRail) {
+    vector<DualRail> piRails;
+    DualRail::packCubes(vector<string>(1, cube), 0, 1, piRails);
+    faultSim.simulateCubes(piRails, 1);
+    return cube;
   }
 
-  char gateType = g->get_gateType();
-  char gateValue;
-  // Now, set the value of this gate based on its logical function and its input values
-  switch(gateType) {   
-  case GATE_NAND: { gateValue = evalGate(inputVals, 0, 1); break; }
-  case GATE_NOR: { gateValue = evalGate(inputVals, 1, 1); break; }
-  case GATE_AND: { gateValue = evalGate(inputVals, 0, 0); break; }
-  case GATE_OR: { gateValue = evalGate(inputVals, 1, 0); break; }
-  case GATE_BUFF: { gateValue = inputVals[0]; break; }
-  case GATE_NOT: { gateValue = LogicNot(inputVals[0]); break; }
-  case GATE_XOR: { gateValue = EvalXORGate(inputVals, 0); break; }
-  case GATE_XNOR: { gateValue = EvalXORGate(inputVals, 1); break; }
-  case GATE_FANOUT: {gateValue = inputVals[0]; break; }
-  default: { cout << "ERROR: Do not know how to evaluate gate type " << gateType << endl; assert(false);}
-  }    
-
-  return gateValue;
-}
+  string test = fillCube(cube);
+  vector<uint64_t> piWords(test.size());
+  for (int i=0; i<test.size(); i++)
+    piWords[i] = (test[i] == '1') ? 1 : 0;
 
+  faultSim.simulate(piWords, 1);
+  return test;
+}
 
-/** @brief Evaluate a NAND, NOR, AND, or OR gate.
- * \param in The logic value's of this gate's inputs.
- * \param c The controlling value of this gate type (e.g. c==0 for an AND or NAND gate)
- * \param i The inverting value for this gate (e.g. i==0 for AND and i==1 for NAND)
- * \returns The logical value produced by this gate (not including a possible fault on this gate).
- * \note You do not need to change this function.
+/** @brief Fault simulate random patterns, 64 at a time, until they stop paying off.
+ *
+ * Patterns come from an LFSR (so they are the same in every run) and are simulated against the
+ * faults \a faultSim has not detected yet. This stops when a block of 64 patterns detects less
+ * than randomCutoff percent of the fault list, or when every fault is detected. For each fault
+ * it detects, \a detectingTest gets the first random pattern that detects it; these are the
+ * useful random patterns, and they are written to the output file like the other tests.
+ * @param faultSim The fault simulator holding the fault list
+ * @param myCircuit The circuit
+ * @param detectingTest Output: the detecting pattern of each fault detected here
  */
-char evalGate(vector<char> in, int c, int i) {
-
-  // Are any of the inputs of this gate the controlling value?
-  bool anyC = find(in.begin(), in.end(), c) != in.end();
-  
-  // Are any of the inputs of this gate unknown?
-  bool anyUnknown = (find(in.begin(), in.end(), LOGIC_X) != in.end());
-
-  int anyD    = find(in.begin(), in.end(), LOGIC_D)    != in.end();
-  int anyDBar = find(in.begin(), in.end(), LOGIC_DBAR) != in.end();
-
-
-  // if any input is c or we have both D and D', then return c^i
-  if ((anyC) || (anyD && anyDBar))
-    return (i) ? LogicNot(c) : c;
-  
-  // else if any input is unknown, return unknown
-  else if (anyUnknown)
-    return LOGIC_X;
-
-  // else if any input is D, return D^i
-  else if (anyD)
-    return (i) ? LOGIC_DBAR : LOGIC_D;
+void randomPhase(FaultSim &faultSim, const Circuit* myCircuit, vector<string> &detectingTest) {
+  int numPIs = myCircuit->getPIIndices().size();
+  int numFaults = faultSim.getNumberFaults();
+  Lfsr lfsr(RANDOM_SEED);
+  vector<uint64_t> piWords(numPIs);
+  vector<char> useful(PATTERNS_PER_WORD);
+  int numBlocks = 0, numUseful = 0, numDetected = 0;
+
+  while (faultSim.getNumberDetected() < numFaults) {
+    for (int i=0; i<numPIs; i++)
+      piWords[i] = lfsr.nextWord();
+    numBlocks++;
+
+    int n = faultSim.simulate(piWords, ~(uint64_t)0);
+    numDetected += n;
+
+    // Pattern k is useful if it is the first pattern of the block to detect some fault.
+    fill(useful.begin(), useful.end(), 0);
+    vector<string> patterns(PATTERNS_PER_WORD);
+    const vector<int>& detected = faultSim.getLastDetected();
+    const vector<uint64_t>& words = faultSim.getLastDetectWords();
+    for (int i=0; i<detected.size(); i++) {
+      int k = 0;
+      while (((words[i] >> k) & 1) == 0)
+        k++;
+      if (!useful[k]) {
+        useful[k] = 1;
+        numUseful++;
+        for (int p=0; p<numPIs; p++)
+          patterns[k] += ((piWords[p] >> k) & 1) ? '1' : '0';
+      }
+      detectingTest[detected[i]] = patterns[k];
+    }
 
-  // else if any input is D', return D'^i
-  else if (anyDBar)
-    return (i) ? LOGIC_D : LOGIC_DBAR;
+    if (100.0 * n < randomCutoff * numFaults)
+      break;
+  }
 
-  // else return ~(c^i)
-  else
-    return LogicNot((i) ? LogicNot(c) : c);
+  cout << "Random patterns: " << numBlocks*PATTERNS_PER_WORD << " simulated, " << numUseful << " useful, "
+       << numDetected << " of " << numFaults << " faults detected" << endl;
 }
 
-/** @brief Evaluate an XOR or XNOR gate.
- * \param in The logic value's of this gate's inputs.
- * \param inv The inverting value for this gate (e.g. i==0 for XOR and i==1 for XNOR)
- * \returns The logical value produced by this gate (not including a possible fault on this gate).
- * \note You do not need to change this function.
+/** @brief Dynamic compaction: extend a test so it also detects other faults.
+ *
+ * The PIs the test assigns stay fixed. For each later fault in the list that is not
+ * detected yet, PODEM tries to detect it too, by assigning only PIs that are still X, with
+ * at most secondaryBacktracks backtracks (see AtpgEngine::extendTest()). This stops when the
+ * test has no X inputs left, or every fault has been tried.
+ * @param engine The engine to use
+ * @param cube The test, as printed to the output file (one 0, 1 or X per PI)
+ * @param primary The fault the test was generated for
+ * @param faultSim The fault list (and, except in pipeline mode, which faults are detected)
+ * @param myCircuit The circuit
+ * @return The extended test, in the same form as \a cube
  */
-char EvalXORGate(vector<char> in, int inv) {
-
-  // if any unknowns, return unknown
-  bool anyUnknown = (find(in.begin(), in.end(), LOGIC_X) != in.end());
-  if (anyUnknown)
-    return LOGIC_X;
-
-  // Otherwise, let's count the numbers of ones and zeros for faulty and fault-free circuits.
-  // This is not required for your project, but this will with with XOR and XNOR with > 2 inputs.
-  int onesFaultFree = 0;
-  int onesFaulty = 0;
-
-  for (int i=0; i<in.size(); i++) {
-    switch(in[i]) {
-    case LOGIC_ZERO: {break;}
-    case LOGIC_ONE: {onesFaultFree++; onesFaulty++; break;}
-    case LOGIC_D: {onesFaultFree++; break;}
-    case LOGIC_DBAR: {onesFaulty++; break;}
-    default: {cout << "ERROR: Do not know how to process logic value " << in[i] << " in Gate::EvalXORGate()" << endl; return LOGIC_X;}
+string compactTest(AtpgEngine &engine, const string &cube, int primary, const FaultSim* faultSim, const Circuit* myCircuit) {
+  vector<char> piValues(cube.size());
+  int numX = 0;
+  for (int i=0; i<cube.size(); i++) {
+    piValues[i] = (cube[i] == '1') ? LOGIC_ONE : ((cube[i] == '0') ? LOGIC_ZERO : LOGIC_X);
+    if (piValues[i] == LOGIC_X)
+      numX++;
+  }
+  engine.setTestCube(piValues);
+
+  for (int f=primary+1; (f < faultSim->getNumberFaults()) && (numX > 0); f++) {
+    bool detected = pipeline ? faultStatus[f].load(memory_order_acquire) : faultSim->isDetected(f);
+    if (detected)
+      continue;
+    if (engine.extendTest(faultSim->getFaultGate(f), faultSim->getFaultType(f), secondaryBacktracks) == PODEM_TEST_FOUND) {
+      const vector<uint32_t>& pis = myCircuit->getPIIndices();
+      numX = 0;
+      for (int i=0; i<pis.size(); i++) {
+        piValues[i] = engine.getValue(pis[i]);
+        if (piValues[i] == LOGIC_X)
+          numX++;
+      }
     }
   }
-  
-  int XORVal;
-
-  if ((onesFaultFree%2 == 0) && (onesFaulty%2 ==0))
-    XORVal = LOGIC_ZERO;
-  else if ((onesFaultFree%2 == 1) && (onesFaulty%2 ==1))
-    XORVal = LOGIC_ONE;
-  else if ((onesFaultFree%2 == 1) && (onesFaulty%2 ==0))
-    XORVal = LOGIC_D;
-  else
-    XORVal = LOGIC_DBAR;
-
-  return (inv) ? LogicNot(XORVal) : XORVal;
 
+  string test;
+  for (int i=0; i<piValues.size(); i++)
+    test += printPIValue(piValues[i]);
+  return test;
 }
 
-
-/** @brief Perform a logical NOT operation on a logical value using the LOGIC_* macros
- * \note You will not need to modify this function.
- */
-int LogicNot(int logicVal) {
-  if (logicVal == LOGIC_ONE)
-    return LOGIC_ZERO;
-  if (logicVal == LOGIC_ZERO)
-    return LOGIC_ONE;
-  if (logicVal == LOGIC_D)
-    return LOGIC_DBAR;
-  if (logicVal == LOGIC_DBAR)
-    return LOGIC_D;
-  if (logicVal == LOGIC_X)
-    return LOGIC_X;
-      
-  cout << "ERROR: Do not know how to invert " << logicVal << " in LogicNot(int logicVal)" << endl;
-  return LOGIC_UNSET;
+/** @brief Returns the test cube with each X replaced by a random 0 or 1 (from fillGenerator). */
+string fillCube(const string &cube) {
+  string test = cube;
+  for (int i=0; i<test.size(); i++)
+    if (test[i] == 'X')
+      test[i] = (fillGenerator() & 1) ? '1' : '0';
+  return test;
 }
 
-/** @brief Set the value of Gate* g to value gateValue, accounting for any fault on g.
-    \note You will not need to modify this.
- */
-void setValueCheckFault(Gate* g, char gateValue) {
-  if ((g->get_faultType() == FAULT_SA0) && (gateValue == LOGIC_ONE)) 
-  	g->setValue(LOGIC_D);
-  else if ((g->get_faultType() == FAULT_SA0) && (gateValue == LOGIC_DBAR)) 
-  	g->setValue(LOGIC_ZERO);
-  else if ((g->get_faultType() == FAULT_SA1) && (gateValue == LOGIC_ZERO)) 
-  	g->setValue(LOGIC_DBAR);
-  else if ((g->get_faultType() == FAULT_SA1) && (gateValue == LOGIC_D)) 
-  	g->setValue(LOGIC_ONE);
-  else
-  	g->setValue(gateValue);
-}
-
-// End of functions for circuit simulation
-////////////////////////////////////////////////////////////
-
-
-/////////////////////////////////////////////////////////
-// Begin functions for PODEM.
-
-// TODO
-/** @brief PODEM recursion.
+/** @brief Run PODEM and fault simulation as a pipeline, over the whole fault list.
  *
- * \note For Part 1, you must write this, following the pseudocode in class and in the code's comments.
+ * numThreads PODEM threads take faults from a work-stealing queue and queue the tests they
+ * find. One fault simulation thread takes up to 64 queued tests at a time, fills their X inputs,
+ * simulates them in parallel against the faults not detected yet, and publishes the faults they
+ * detect in faultStatus. A PODEM thread skips a fault that is already marked there.
+ *
+ * When this returns, faultResults holds the PODEM result of every fault that was not skipped
+ * (PODEM_SKIPPED for the others), every fault that any test detects is marked detected in \a faultSim, and \a detectingTest
+ * holds the filled test that detected it.
  */
-bool podemRecursion(Circuit* myCircuit) {
-
-  // If D or D' is at an output, then return true
-    char val;
-	
-	vector<Gate*> opGates = myCircuit->getPOGates();
-	for (int i=0; i<opGates.size(); i++) {
-    val = opGates[i]->getValue();
-    if ((val == LOGIC_D) || (val == LOGIC_DBAR)) 
-      return true;    
-	}
-
-   Gate* g;
-   char v;  
-
-  // Call the getObjective function. Store the result in g and v.    
-  // If getObjective fails, return false	
-  
-	bool obj = getObjective(g, v, myCircuit);
-	///////////
-	if (obj == false ) return false;
-	
-  Gate* pi;
-  char piVal;
-  
-  // Call the backtrace function. Store the result in pi and piVal.
-  
-  backtrace(pi, piVal, g, v, myCircuit);
-  
-  // Set the value of pi to piVal. Use your setValueCheckFault function (see above)
-  // to make sure if there is a fault on the PI gate, it correctly gets set.
-  
-  setValueCheckFault(pi, piVal);
-  
-  // Now, determine the implications of the input you set by simulating 
-  // the circuit by calling simFullCircuit(myCircuit);
-  
-  simFullCircuit(myCircuit);
-   
-  
-  if (podemRecursion(myCircuit)) return true;
-  // If the recursive call fails, set the opposite PI value, simulate, it and recurse.
-  // If this recursive call succeeds, return true.
-  
-  char notpiVal;
-  notpiVal= LogicNot(piVal);
-  
-  setValueCheckFault(pi, notpiVal); 
-  
-  simFullCircuit(myCircuit);
-  if (podemRecursion(myCircuit)) return true;
-  
-  // If we get to here, neither pi=v nor pi = v' worked. So, set pi to value X and 
-  // return false.
-  
-  setValueCheckFault(pi, LOGIC_X);
-
-  return false;
-
+void runPipeline(FaultSim &faultSim, Circuit* myCircuit, vector<string> &detectingTest) {
+  int numFaults = faultSim.getNumberFaults();
+  FaultResult skipped = { PODEM_SKIPPED, "", 0, false, RACE_NONE };
+  faultResults.assign(numFaults, skipped);
+  vector< atomic<char> > status(numFaults);
+  for (int f=0; f<numFaults; f++)
+    status[f].store(faultSim.isDetected(f));
+  faultStatus.swap(status);
+  cubeQueue.clear();
+  numGeneratorsRunning = numThreads;
+
+  WorkQueue queue(numThreads);
+  for (int f=0; f<numFaults; f++)
+    queue.push(f % numThreads, f);
+
+  vector<thread> threads;
+  for (int w=0; w<numThreads; w++)
+    threads.push_back(thread(pipelineGenerator, w, &queue, &faultSim, myCircuit));
+  threads.push_back(thread(pipelineFaultSim, &faultSim, &detectingTest));
+  for (int i=0; i<threads.size(); i++)
+    threads[i].join();
+
+  // Every fault now has its result (or was detected, and will not look at it).
+  resultReady.assign(numFaults, 1);
 }
 
-// Find the objective for myCircuit. The objective is stored in g, v.
-// 
-// TODO Write this function, based on the pseudocode from
-// class or your textbook.
-/** @brief PODEM objective function.
- *  \param g Use this pointer to store the objective Gate your function picks.
- *  \param v Use this char to store the objective value your function picks.
- *  \returns True if the function is able to determine an objective, and false if it fails.
- * \note For Part 2, you must write this, following the pseudocode in class and the code's comments.
- */
-
-bool getObjective(Gate* &g, char &v, Circuit* myCircuit) {
-
-  // First you will need to check if the fault is activated yet.
-  // Note that in the setup above we set up a global variable
-  // Gate* faultLocation which represents the gate with the stuck-at
-  // fault on its output. Use that when you check if the fault is
-  // excited.
+/** @brief The body of PODEM thread w in the pipeline (see runPipeline()). */
+void pipelineGenerator(int w, WorkQueue* queue, const FaultSim* faultSim, Circuit* myCircuit) {
+  AtpgEngine engine(myCircuit);
+  engine.setBacktrackLimit(backtrackLimit);
+  engine.setTimeLimit(timeLimit);
+  if (satFallback)
+    engine.setSatFallback(satDecisionLimit, satConflictLimit);
+  engine.setImplicationTable(learnedTable);
+  engine.setDualRail(dualRail);
+
+  int f;
+  while (queue->pop(w, f)) {
+    if (faultStatus[f].load(memory_order_acquire))
+      continue;
+
+    FaultResult r = runPodem(engine, faultSim->getFaultGate(f), faultSim->getFaultType(f), myCircuit);
+    if ((r.res == PODEM_TEST_FOUND) && dynamicCompaction)
+      r.test = compactTest(engine, r.test, f, faultSim, myCircuit);
+    faultResults[f] = r;
+
+    if (r.res == PODEM_TEST_FOUND) {
+      lock_guard<mutex> lock(cubeMutex);
+      cubeQueue.push_back(r.test);
+      cubeCond.notify_one();
+    }
+  }
 
-  
-  // Another note: if the fault is not excited but the fault 
-  // location value is not X, then we have failed to activate 
-  // the fault. In this case getObjective should fail and Return false.  
-	
-	if (faultLocation->getValue()== LOGIC_X) {g= faultLocation; v=faultActivationVal; 
-		return true;}
-	
-	if (faultLocation->getValue()== LOGIC_ONE || faultLocation->getValue()== LOGIC_ZERO)
-	{return false;} 
-	//setValueCheckFault(faultLocation, faultLocation->getValue());
-
-  // If the fault is already activated, then you will need to 
-  // use the D-frontier to find an objective.
-  // Before you use the D-frontier you should update it by running:
-  
-  updateDFrontier(myCircuit);
+  lock_guard<mutex> lock(cubeMutex);
+  numGeneratorsRunning--;
+  cubeCond.notify_one();
+}
 
-  // This function should update the global D-frontier variable
-  // vector<Gate*> dFrontier;
-  
-  // If the D frontier is empty after update, then getObjective fails
-  // and should return false.
-	
-	if (dFrontier.empty()) return false;
-	
-	
-  // getObjective needs to choose a gate from the D-Frontier.
-  // For part 1, pick dFrontier[0] if you want to match my reference outputs.
-	Gate* d;	
-	d = dFrontier[0];
-	
-	// Later, a possible optimization is to use the 
-  // SCOAP observability metric or other smart methods to choose this carefully.
-    
+/** @brief The body of the fault simulation thread in the pipeline (see runPipeline()). */
+void pipelineFaultSim(FaultSim* faultSim, vector<string>* detectingTest) {
+  vector<string> batch;
+  while (true) {
+
+    // Wait for tests, and take up to 64 of them.
+    batch.clear();
+    {
+      unique_lock<mutex> lock(cubeMutex);
+      while (cubeQueue.empty() && (numGeneratorsRunning > 0))
+        cubeCond.wait(lock);
+      if (cubeQueue.empty())
+        return;
+      while (!cubeQueue.empty() && (batch.size() < PATTERNS_PER_WORD)) {
+        batch.push_back(cubeQueue.front());
+        cubeQueue.pop_front();
+      }
+    }
 
-  // Lastly, set the values of g and v based on the
-  // gate you chose from the D-Frontier.
-
-	
-	vector<Gate*> dinputs = d->get_gateInputs();
-	
-		for (int i=0; i<dinputs.size(); i++) 
-			{
-				if (dinputs[i]->getValue()== LOGIC_X)
-				{
-					g = dinputs[i]; break;
-				}
-			}
-			
-	if (d->get_gateType()==GATE_AND || d->get_gateType()==GATE_NAND) v=LOGIC_ONE;
-	else if (d->get_gateType()==GATE_OR || d->get_gateType()==GATE_NOR) v=LOGIC_ZERO;
-	else if (d->get_gateType()==GATE_XOR || d->get_gateType()==GATE_XNOR) v=LOGIC_ZERO;
-	else v=LOGIC_X;
-	
-	
-  return true;
+    // Test k of the batch goes in bit k of the PI words.
+    uint64_t mask = (batch.size() == PATTERNS_PER_WORD) ? ~(uint64_t)0 : (((uint64_t)1 << batch.size()) - 1);
+    if (dualRail) {
+      vector<DualRail> piRails;
+      DualRail::packCubes(batch, 0, batch.size(), piRails);
+      faultSim->simulateCubes(piRails, mask);
+    }
+    else {
+      vector<uint64_t> piWords(batch[0].size(), 0);
+      for (int k=0; k<batch.size(); k++) {
+        batch[k] = fillCube(batch[k]);
+        for (int i=0; i<piWords.size(); i++)
+          if (batch[k][i] == '1')
+            piWords[i] |= (uint64_t)1 << k;
+      }
+      faultSim->simulate(piWords, mask);
+    }
 
+    // Record the first test of the batch that detects each newly detected fault.
+    const vector<int>& detected = faultSim->getLastDetected();
+    const vector<uint64_t>& words = faultSim->getLastDetectWords();
+    for (int i=0; i<detected.size(); i++) {
+      int k = 0;
+      while (((words[i] >> k) & 1) == 0)
+        k++;
+      (*detectingTest)[detected[i]] = batch[k];
+      faultStatus[detected[i]].store(1, memory_order_release);
+    }
+  }
 }
 
+////////////////////////////////////////////////////////////////////////////
 
-// A very simple method to update the D frontier.
-// TODO: Write this code based on the pseudocode below.
-/** @brief A simple method to compute the set of gates on the D frontier.
+/** @brief Static compaction of the tests, once every fault has been processed.
  *
- * \note For Part 1, you must write this. The simplest form follows the pseudocode included in the comments.
+ * Compatible test cubes are merged (see TestCompactor::mergeCubes()) and their X inputs filled.
+ * A test with a fill that happened to detect a fault might not still detect it once merged, so
+ * the original test of any fault the merged patterns miss is added back. Reverse-order fault
+ * simulation then drops the patterns that are not needed, and what is left is written to
+ * compactedPatternFile, one pattern per line.
+ * @param faultSim The fault simulator holding the fault list (its detected flags are overwritten)
+ * @param tests The test written to the output file for each fault (empty if there is none)
+ * @param myCircuit The circuit
+ * @return The number of faults the compacted patterns detect, or -1 if the file cannot be written
  */
+int staticCompaction(FaultSim &faultSim, const vector<string> &tests, const Circuit* myCircuit) {
+  TestCompactor compactor(myCircuit);
+  int numTests = 0;
+  for (int f=0; f<tests.size(); f++) {
+    if (!tests[f].empty()) {
+      compactor.addCube(tests[f]);
+      numTests++;
+    }
+  }
 
-void updateDFrontier(Circuit* myCircuit) {
-  // Procedure:
-  //  - clear the dFrontier vector (stored as the global variable dFrontier -- see the top of the file)
-  
-	dFrontier.clear();
-	
-  //  - loop over all gates in the circuit; for each gate, check if it should be on D-frontier; if it is,
-  //    add it to the dFrontier vector.
-
-	Gate* G;
-	int numberofgates = myCircuit->getNumberGates();
-	
-	for (int i=0; i< numberofgates; i++)
-	{
-		G = myCircuit->getGate(i);
-		if (G->getValue() != LOGIC_X) continue;
-		else
-		{
-			vector<Gate*> Ginputs = G->get_gateInputs(); 
-			for (int j=0; j<Ginputs.size(); j++) 
-				{ 
-					if (Ginputs[j]->getValue()== LOGIC_D || Ginputs[j]->getValue() == LOGIC_DBAR)
-					{
-						dFrontier.push_back(G); break;
-					}
-					
-				}		
-			
-		}
-	}
-  
-}
+  compactor.mergeCubes();
+  Lfsr fill(COMPACTION_SEED);
+  vector<string> patterns = compactor.getPatterns(fill);
+  int numMerged = patterns.size();
+
+  // Add back the tests of the faults the merged patterns do not detect.
+  faultSim.clearDetected();
+  vector<uint64_t> piWords;
+  for (int p=0; p<patterns.size(); p+=PATTERNS_PER_WORD) {
+    int n = min((int)patterns.size() - p, PATTERNS_PER_WORD);
+    TestCompactor::packPatterns(patterns, p, n, piWords);
+    faultSim.simulate(piWords, (n == PATTERNS_PER_WORD) ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1));
+  }
+  for (int f=0; f<tests.size(); f++)
+    if (!tests[f].empty() && !faultSim.isDetected(f))
+      patterns.push_back(fillCube(tests[f]));
+  int numRestored = patterns.size() - numMerged;
 
+  int numDetected = TestCompactor::reverseOrderSim(faultSim, patterns);
 
-// Backtrace: given objective objGate and objVal, then figure out which input (pi) to set 
-// and which value (piVal) to set it to.
-// TODO: write this
+  ofstream patternStream(compactedPatternFile.c_str());
+  if (!patternStream.is_open()) {
+    cout << "ERROR: Cannot open file " << compactedPatternFile << " for output" << endl;
+    return -1;
+  }
+  for (int p=0; p<patterns.size(); p++)
+    patternStream << patterns[p] << endl;
+  patternStream.close();
 
-/** @brief PODEM backtrace function
- * \param pi Output: A Gate pointer to the primary input your backtrace function found.
- * \param piVal Output: The value you want to set that primary input to
- * \param objGate Input: The objective Gate (computed by getObjective)
- * \param objVal Input: the objective value (computed by getObjective)
- * \note Write this function based on the psuedocode from class.
- */
-void backtrace(Gate* &pi, char &piVal, Gate* objGate, char objVal, Circuit* myCircuit) {
-
-	pi = objGate;int k1;int cnt=0;
-	int num_inversions;
-	char gatetype = pi->get_gateType();
-	
-	if (gatetype == GATE_NOR || gatetype == GATE_NOT || gatetype == GATE_NAND || gatetype == GATE_XNOR)
-		num_inversions=1;
-	else num_inversions=0;
-	
-	
-	while (pi->get_gateType()!=GATE_PI)
-	{ 
-		vector<Gate*> gateinputs = pi->get_gateInputs();//
-		
-		for (k1=0; k1<gateinputs.size(); k1++) 
-			{ 
-				if (gateinputs[k1]->getValue()== LOGIC_X) {pi=gateinputs[k1]; break;} 
-				
-			}
-			
-			gatetype = pi->get_gateType();
-			
-		if (gatetype == GATE_NOR || gatetype == GATE_NOT || gatetype == GATE_NAND || gatetype == GATE_XNOR)
-		{num_inversions++; }
-	}
-	
-	if (num_inversions%2==1) piVal= LogicNot(objVal);
-	else piVal = objVal;
-	
+  cout << "Static compaction: " << numTests << " tests, " << numMerged << " after merging (+"
+       << numRestored << " restored), " << patterns.size() << " after reverse-order fault simulation" << endl;
+  return numDetected;
 }
-
-
-////////////////////////////////////////////////////////////////////////////
-// Place any new functions you add here, between these two bars.
-
-
-
-////////////////////////////////////////////////////////////////////////////
-
-